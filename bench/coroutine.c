@@ -0,0 +1,138 @@
+/*
+ * coroutine.c -- coroutine switch benchmark
+ *
+ * Copyright (c) 2011-2026 David Demelier <markand@malikania.fr>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include <SDL3/SDL.h>
+
+#include "coroutine.h"
+#include "stris.h"
+#include "sys.h"
+#include "util.h"
+
+/*
+ * Number of frames run with all coroutines ready.
+ */
+#define FRAMES 100000
+
+/*
+ * Number of coroutines run on each frame.
+ */
+#define COROUTINES 16
+
+struct stris stris;
+struct sconf sconf;
+
+/*
+ * Resident memory of the process in bytes, 0 if unknown.
+ */
+static size_t
+resident(void)
+{
+	FILE *fp;
+	size_t size, pages = 0;
+
+	if (!(fp = fopen("/proc/self/statm", "r")))
+		return 0;
+	if (fscanf(fp, "%zu %zu", &size, &pages) != 2)
+		pages = 0;
+
+	fclose(fp);
+
+	return pages * sys_page_size();
+}
+
+static void
+stackful_entry(struct coroutine *)
+{
+	for (;;)
+		coroutine_yield();
+}
+
+static int
+stackless_step(struct coroutine *self)
+{
+	COROUTINE_BEGIN(self);
+
+	for (;;)
+		COROUTINE_YIELD(self);
+
+	COROUTINE_END(self);
+}
+
+static void
+bench(const char *name, struct coroutine *cos, size_t cosz)
+{
+	uint64_t start, elapsed;
+	size_t before, after;
+
+	before = resident();
+
+	for (size_t i = 0; i < cosz; ++i)
+		coroutine_init(&cos[i]);
+
+	/* Start them all once before measuring, this touches their stacks. */
+	coroutine_run(0, UINT64_MAX);
+
+	after = resident();
+
+	start = SDL_GetTicksNS();
+
+	for (int i = 0; i < FRAMES; ++i)
+		coroutine_run(0, UINT64_MAX);
+
+	elapsed = SDL_GetTicksNS() - start;
+
+	printf("%-12s %-10s %8.1f ns/switch", name,
+	    cos->handle ? "stackful" : "stackless",
+	    (double)elapsed / ((double)FRAMES * cosz));
+
+	/* Resident memory added by the coroutines, not counting their object. */
+	if (before && after)
+		printf(" %10zu resident bytes/coroutine\n",
+		    (after > before ? after - before : 0) / cosz);
+	else
+		printf(" %10s resident bytes/coroutine\n", "unknown");
+
+	for (size_t i = 0; i < cosz; ++i)
+		coroutine_finish(&cos[i]);
+}
+
+int
+main(void)
+{
+	struct coroutine cos[COROUTINES];
+
+	memset(cos, 0, sizeof (cos));
+
+	for (size_t i = 0; i < LEN(cos); ++i) {
+		cos[i].entry = stackful_entry;
+		cos[i].stack = COROUTINE_STACK_SMALL;
+	}
+
+	bench("entry", cos, LEN(cos));
+	memset(cos, 0, sizeof (cos));
+
+	for (size_t i = 0; i < LEN(cos); ++i) {
+		cos[i].step = stackless_step;
+		cos[i].stack = COROUTINE_STACK_SMALL;
+	}
+
+	bench("step", cos, LEN(cos));
+}
@@ -21,66 +21,302 @@
 
 #include "board.h"
 #include "shape.h"
+#include "util.h"
+
+/*
+ * Width dependent operations, see board_init.
+ */
+struct board_kernel {
+	int w;
+	int (*check)(const struct board *, const struct shape *);
+	void (*pop)(struct board *, uint64_t);
+};
+
+/*
+ * Move a shape row mask to the column x which may be negative, columns falling
+ * outside of the board are discarded.
+ */
+static inline uint64_t
+board_shift(uint8_t mask, int x)
+{
+	return x >= 0 ? (uint64_t)mask << x : (uint64_t)(mask >> -x);
+}
+
+/*
+ * Recompute the surface height of the column x, nothing can be above the
+ * current height so the search starts from there.
+ */
+static void
+board_surface(struct board *b, int x)
+{
+	int y;
+
+	for (y = b->h - b->heights[x]; y < b->h; ++y)
+		if (b->rows[y] >> x & 1)
+			break;
+
+	b->heights[x] = b->h - y;
+}
+
+/*
+ * The following functions take the width as a parameter so that they can be
+ * instantiated with a constant one which lets the compiler fold the bound
+ * checks and the row copies.
+ */
+static inline int
+board_check_w(const struct board *b, const struct shape *s, int w)
+{
+	const struct shape_info *info = shape_info(s);
+
+	/* Shape bounding box is out of bound. */
+	if (s->x + info->x < 0 || s->x + info->x + info->w > w)
+		return 0;
+	if (s->y + info->y + info->h > b->h)
+		return 0;
+
+	/* Shape rows collide with board. */
+	for (int r = info->y; r < info->y + info->h; ++r)
+		if (b->rows[s->y + r] & board_shift(info->rows[r], s->x))
+			return 0;
+
+	return 1;
+}
+
+static inline void
+board_pop_w(struct board *b, uint64_t lines, int w)
+{
+	int dst, src, top, count = 1;
+
+	/*
+	 * Start from the lowest cleared row, everything below stays in place.
+	 * Then move every kept row down to the next free destination.
+	 */
+	for (dst = b->h - 1; !(lines >> dst & 1); --dst)
+		continue;
+
+	assert(b->rows[dst] == b->full);
+
+	for (src = dst - 1; src >= 0; --src) {
+		if (lines >> src & 1) {
+			assert(b->rows[src] == b->full);
+			count++;
+			continue;
+		}
+
+		memcpy(b->cells[dst], b->cells[src], w);
+		b->rows[dst--] = b->rows[src];
+	}
+
+	/* Remaining rows on top are now empty. */
+	memset(b->cells, 0, (dst + 1) * sizeof (b->cells[0]));
+	memset(b->rows, 0, (dst + 1) * sizeof (b->rows[0]));
+
+	/*
+	 * Removed rows were full so they all lie below the surface of every
+	 * column which goes down at least by their number. If the highest cell
+	 * of the column was removed, holes may lie below so search again.
+	 */
+	for (int x = 0; x < w; ++x) {
+		top = b->h - b->heights[x];
+		b->heights[x] -= count;
+
+		if (lines >> top & 1)
+			board_surface(b, x);
+	}
+}
+
+#define BOARD_KERNEL(W)                                                         \
+static int                                                                      \
+board_check_##W(const struct board *b, const struct shape *s)                   \
+{                                                                               \
+        return board_check_w(b, s, W);                                          \
+}                                                                               \
+                                                                                \
+static void                                                                     \
+board_pop_##W(struct board *b, uint64_t lines)                                  \
+{                                                                               \
+        board_pop_w(b, lines, W);                                               \
+}
+
+BOARD_KERNEL(10)
+BOARD_KERNEL(16)
+BOARD_KERNEL(32)
+BOARD_KERNEL(64)
+
+static int
+board_check_any(const struct board *b, const struct shape *s)
+{
+	return board_check_w(b, s, b->w);
+}
+
+static void
+board_pop_any(struct board *b, uint64_t lines)
+{
+	board_pop_w(b, lines, b->w);
+}
+
+static const struct board_kernel kernels[] = {
+	{ 10, board_check_10,   board_pop_10    },
+	{ 16, board_check_16,   board_pop_16    },
+	{ 32, board_check_32,   board_pop_32    },
+	{ 64, board_check_64,   board_pop_64    },
+	{  0, board_check_any,  board_pop_any   }
+};
+
+void
+board_init(struct board *b, int w, int h)
+{
+	assert(b);
+	assert(w >= BOARD_W_MIN && w <= BOARD_W_MAX);
+	assert(h >= BOARD_H_MIN && h <= BOARD_H_MAX);
+
+	size_t i;
+
+	memset(b, 0, sizeof (*b));
+	b->w = w;
+	b->h = h;
+	b->full = w == 64 ? UINT64_MAX : (UINT64_C(1) << w) - 1;
+
+	/* Last one is the generic version. */
+	for (i = 0; i < LEN(kernels) - 1 && kernels[i].w != w; ++i)
+		continue;
+
+	b->kernel = &kernels[i];
+}
+
+void
+board_clear(struct board *b)
+{
+	assert(b);
+
+	memset(b->cells, 0, sizeof (b->cells));
+	memset(b->rows, 0, sizeof (b->rows));
+	memset(b->heights, 0, sizeof (b->heights));
+}
 
 void
-board_clear(Board b)
+board_put(struct board *b, int x, int y, int color)
 {
 	assert(b);
+	assert(x >= 0 && x < b->w);
+	assert(y >= 0 && y < b->h);
+
+	b->cells[y][x] = color;
 
-	memset(b, 0, BOARD_H * BOARD_W * sizeof (int));
+	if (color) {
+		b->rows[y] |= UINT64_C(1) << x;
+
+		if (b->heights[x] < b->h - y)
+			b->heights[x] = b->h - y;
+	} else {
+		b->rows[y] &= ~(UINT64_C(1) << x);
+
+		if (b->heights[x] == b->h - y)
+			board_surface(b, x);
+	}
 }
 
 void
-board_pop(Board b, int y)
+board_pop(struct board *b, uint64_t lines)
 {
-	memmove(b + 1, b, y * sizeof (b[y]));
-	memset(b, 0, sizeof (b[0]));
+	assert(b);
+	assert(b->h == 64 || lines >> b->h == 0);
+
+	if (lines)
+		b->kernel->pop(b, lines);
 }
 
 int
-board_check(const Board b, const struct shape *s)
+board_check(const struct board *b, const struct shape *s)
 {
 	assert(b);
 	assert(s);
 
-	for (int r = 0; r < 4; ++r) {
-		for (int c = 0; c < 4; ++c) {
-			// Empty cell in definition, skip.
-			if (!s->def[s->o][r][c])
-				continue;
+	return b->kernel->check(b, s);
+}
 
-			// Shape cell is out of bound.
-			if (s->x + c < 0 || s->x + c >= BOARD_W || s->y + r >= BOARD_H)
-				return 0;
-			// Shape cell collide with board.
-			if (b[s->y + r][s->x + c])
-				return 0;
-		}
+int
+board_drop(const struct board *b, const struct shape *s)
+{
+	assert(b);
+	assert(s);
+	assert(board_check(b, s));
+
+	const struct shape_info *info = shape_info(s);
+	struct shape probe;
+	int land, y = b->h;
+
+	/* Lowest column bottom resting on its surface. */
+	for (int c = info->x; c < info->x + info->w; ++c) {
+		if (!info->bottom[c])
+			continue;
+
+		land = b->h - b->heights[s->x + c] - info->bottom[c];
+
+		if (land < y)
+			y = land;
 	}
 
-	return 1;
+	/*
+	 * The shape is already below the surface which means it has been
+	 * moved under an overhang, step down until it collides instead.
+	 */
+	if (y < s->y) {
+		for (probe = *s; board_check(b, &probe); ++probe.y)
+			continue;
+
+		y = probe.y - 1;
+	}
+
+	return y;
 }
 
-void
-board_set(Board b, const struct shape *s)
+uint64_t
+board_lines(const struct board *b, const struct shape *s)
 {
 	assert(b);
 	assert(s);
 
-	for (int r = 0; r < 4 && s->y + r < BOARD_H; ++r)
-		for (int c = 0; c < 4 && s->x + c < BOARD_W; ++c)
-			if (s->def[s->o][r][c] && !b[s->y + r][s->x + c])
-				b[s->y + r][s->x + c] = s->k + 1;
+	const struct shape_info *info = shape_info(s);
+	uint64_t lines = 0;
+	int y;
+
+	for (int r = info->y; r < info->y + info->h; ++r) {
+		y = s->y + r;
+
+		if (y >= 0 && y < b->h && b->rows[y] == b->full)
+			lines |= UINT64_C(1) << y;
+	}
+
+	return lines;
 }
 
 void
-board_unset(Board b, const struct shape *s)
+board_set(struct board *b, const struct shape *s)
 {
 	assert(b);
 	assert(s);
 
-	for (int r = 0; r < 4 && s->y + r < BOARD_H; ++r)
-		for (int c = 0; c < 4 && s->x + c < BOARD_W; ++c)
-			if (s->def[s->o][r][c])
-				b[s->y + r][s->x + c] = 0;
+	const struct shape_info *info = shape_info(s);
+	uint64_t bits;
+	int y;
+
+	for (int r = info->y; r < info->y + info->h; ++r) {
+		if ((y = s->y + r) >= b->h)
+			break;
+
+		/* Only fill cells that are inside the board and still empty. */
+		bits = board_shift(info->rows[r], s->x) & b->full & ~b->rows[y];
+		b->rows[y] |= bits;
+
+		for (int x = s->x + info->x; x < s->x + info->x + info->w; ++x) {
+			if (x < 0 || x >= b->w || !(bits >> x & 1))
+				continue;
+
+			b->cells[y][x] = s->k + 1;
+
+			if (b->heights[x] < b->h - y)
+				b->heights[x] = b->h - y;
+		}
+	}
 }
@@ -24,36 +24,130 @@
  * \brief Game main grid.
  */
 
+#include <stdint.h>
+
 /**
- * Number of columns in the board.
+ * Default number of columns in the board.
  */
 #define BOARD_W 10
 
 /**
- * Number of rows in the board.
+ * Default number of rows in the board.
  */
 #define BOARD_H 20
 
+/**
+ * Minimum and maximum number of columns, a row must fit in the bitboard.
+ */
+#define BOARD_W_MIN 4
+#define BOARD_W_MAX 64
+
+/**
+ * Minimum and maximum number of rows, a set of lines must fit in a bitmask.
+ */
+#define BOARD_H_MIN 4
+#define BOARD_H_MAX 64
+
+struct board_kernel;
 struct shape;
 
 /**
- * Typedef the board into two-dimensional array.
+ * \struct board
+ * \brief Game grid.
+ *
+ * The grid is stored twice: once as colors for rendering and once as an
+ * occupancy bitboard where each row is an integer with bit `c` set if the
+ * column `c` is used. Collision checks only use the bitboard.
+ *
+ * Arrays are sized for the largest board, only the first #w columns and #h
+ * rows are used.
  */
-typedef int Board[BOARD_H][BOARD_W];
+struct board {
+	/**
+	 * (read-only)
+	 *
+	 * Number of columns and rows.
+	 */
+	int w;
+	int h;
+
+	/**
+	 * (read-only)
+	 *
+	 * Bitboard value of a completely filled row.
+	 */
+	uint64_t full;
+
+	/**
+	 * (read-only)
+	 *
+	 * Color index + 1 of every cell, 0 if empty.
+	 */
+	uint8_t cells[BOARD_H_MAX][BOARD_W_MAX];
+
+	/**
+	 * (read-only)
+	 *
+	 * Occupancy bitboard.
+	 */
+	uint64_t rows[BOARD_H_MAX];
+
+	/**
+	 * (read-only)
+	 *
+	 * Surface height of every column, this is the number of rows from the
+	 * bottom up to the highest used cell included, 0 if empty.
+	 */
+	uint8_t heights[BOARD_W_MAX];
+
+	/**
+	 * (private)
+	 *
+	 * Functions specialized for the board width.
+	 */
+	const struct board_kernel *kernel;
+};
 
 /**
- * Clear the board.
+ * Initialize an empty board of the given dimensions.
+ *
+ * Collision and line removal use functions specialized for the most common
+ * widths (10, 16, 32 and 64) and a generic version otherwise.
+ *
+ * \pre w >= BOARD_W_MIN && w <= BOARD_W_MAX
+ * \pre h >= BOARD_H_MIN && h <= BOARD_H_MAX
+ * \param w the number of columns
+ * \param h the number of rows
  */
 void
-board_clear(Board board);
+board_init(struct board *board, int w, int h);
 
 /**
- * Remove a line in the board, moving every other lines by one.
+ * Clear the board, dimensions are kept.
+ */
+void
+board_clear(struct board *board);
+
+/**
+ * Set an individual cell.
  *
- * \param line the line row
+ * \param x the column
+ * \param y the row
+ * \param color the color index + 1 (0 to empty the cell)
  */
 void
-board_pop(Board board, int line);
+board_put(struct board *board, int x, int y, int color);
+
+/**
+ * Remove every line set in the bitmask in a single pass, moving the remaining
+ * lines down.
+ *
+ * Every removed line must be full.
+ *
+ * \param lines the bitmask of rows to remove (bit n for row n)
+ */
+void
+board_pop(struct board *board, uint64_t lines);
 
 /**
  * Check if the shape can be placed at its position/orientation.
@@ -62,22 +156,36 @@ board_pop(Board board, int line);
  * \return non-zero if does not collide
  */
 int
-board_check(const Board board, const struct shape *shape);
+board_check(const struct board *board, const struct shape *shape);
 
 /**
- * Place the shape in the board.
+ * Compute the row where the shape would land if dropped straight down from
+ * its current position.
  *
- * \param shape the shape to place
+ * \param shape the shape to drop
+ * \return the landing row
  */
-void
-board_set(Board board, const struct shape *shape);
+int
+board_drop(const struct board *board, const struct shape *shape);
 
 /**
- * Remove the shape from the board by emptying the cells.
+ * Returns the full rows among the ones covered by the shape.
+ *
+ * This is meant to be called once the shape has been placed so that only the
+ * rows it touched are inspected.
  *
- * \param shape the shape to remove
+ * \param shape the shape placed
+ * \return the bitmask of full rows (bit n for row n)
+ */
+uint64_t
+board_lines(const struct board *board, const struct shape *shape);
+
+/**
+ * Place the shape in the board.
+ *
+ * \param shape the shape to place
  */
 void
-board_unset(Board board, const struct shape *shape);
+board_set(struct board *board, const struct shape *shape);
 
 #endif /* STRIS_BOARD_H */
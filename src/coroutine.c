@@ -21,29 +21,222 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include <SDL3/SDL.h>
+
 #include "coroutine.h"
 #include "stris.h"
+#include "sys.h"
 #include "util.h"
 
 /* minicoro configuration. */
-#define MCO_ALLOC(w) alloc(1, w)
-#define MCO_DEALLOC(p, w) free(p)
-#define MCO_DEFAULT_STACK_SIZE 524288
-#define MCO_MIN_STACK_SIZE MCO_DEFAULT_STACK_SIZE
+#define MCO_DEFAULT_STACK_SIZE COROUTINE_STACK_SIZE
 #define MCO_NO_MULTITHREAD
 
 #define MINICORO_IMPL
 #include <minicoro.h>
 
+#if defined(COROUTINE_STACKLESS)
+#       define STACKLESS 1
+#else
+#       define STACKLESS 0
+#endif
+
+/*
+ * Stacks of destroyed coroutines kept for the next ones, state transitions
+ * destroy and create several coroutines at once. Their pages are given back
+ * to the system meanwhile so that only the mappings are kept.
+ */
+static struct {
+	void *base;
+	size_t size;
+} pool[8];
+static size_t poolsz;
+
+/*
+ * Coroutines are linked by class in registration order. Those sleeping are
+ * also kept in a binary min-heap ordered by deadline so that a frame only
+ * looks at the ones due.
+ */
+static struct {
+	struct {
+		struct coroutine *first;
+		struct coroutine *last;
+	} classes[COROUTINE_PRIO_LAST];
+
+	/* next one to dispatch, see coroutine_finish */
+	struct coroutine *next;
+
+	struct coroutine **sleepers;
+	size_t sleepersz;
+	size_t sleeperscap;
+	uint64_t now;
+} sched;
+
+static inline void
+heap_set(size_t i, struct coroutine *co)
+{
+	sched.sleepers[i] = co;
+	co->heap = i;
+}
+
+static void
+heap_up(size_t i)
+{
+	struct coroutine *co = sched.sleepers[i];
+	size_t parent;
+
+	for (; i > 0; i = parent) {
+		parent = (i - 1) / 2;
+
+		if (sched.sleepers[parent]->wake <= co->wake)
+			break;
+
+		heap_set(i, sched.sleepers[parent]);
+	}
+
+	heap_set(i, co);
+}
+
+static void
+heap_down(size_t i)
+{
+	struct coroutine *co = sched.sleepers[i];
+	size_t child;
+
+	while ((child = i * 2 + 1) < sched.sleepersz) {
+		if (child + 1 < sched.sleepersz &&
+		    sched.sleepers[child + 1]->wake < sched.sleepers[child]->wake)
+			child++;
+		if (co->wake <= sched.sleepers[child]->wake)
+			break;
+
+		heap_set(i, sched.sleepers[child]);
+		i = child;
+	}
+
+	heap_set(i, co);
+}
+
+static void
+heap_push(struct coroutine *co)
+{
+	if (sched.sleepersz == sched.sleeperscap) {
+		sched.sleeperscap = sched.sleeperscap ? sched.sleeperscap * 2 : 16;
+		sched.sleepers = realloc(sched.sleepers, sched.sleeperscap * sizeof (*sched.sleepers));
+
+		if (!sched.sleepers)
+			die("realloc: %s\n", strerror(ENOMEM));
+	}
+
+	heap_set(sched.sleepersz++, co);
+	heap_up(co->heap);
+}
+
+static void
+heap_remove(struct coroutine *co)
+{
+	struct coroutine *last;
+	size_t i = co->heap;
+
+	assert(i < sched.sleepersz && sched.sleepers[i] == co);
+
+	last = sched.sleepers[--sched.sleepersz];
+
+	if (last == co)
+		return;
+
+	heap_set(i, last);
+	heap_up(i);
+	heap_down(last->heap);
+}
+
+/*
+ * Deadline of a sleeping coroutine changed.
+ */
+static void
+heap_fix(struct coroutine *co)
+{
+	heap_up(co->heap);
+	heap_down(co->heap);
+}
+
+/*
+ * Allocate a coroutine from the pool or map a new one with a guard page
+ * below.
+ *
+ * minicoro places its own coroutine object at the start of the memory and the
+ * stack right after so an overflow first damages that object. Small overflows
+ * are only caught by the minicoro magic number check on the next resume, the
+ * guard page faults only once the whole object was overwritten.
+ */
+static void *
+stack_alloc(size_t size, void *)
+{
+	size_t page = sys_page_size();
+	void *base;
+
+	size = ((size + page - 1) / page + 1) * page;
+
+	for (size_t i = 0; i < poolsz; ++i) {
+		if (pool[i].size == size) {
+			base = pool[i].base;
+			pool[i] = pool[--poolsz];
+
+			return (char *)base + page;
+		}
+	}
+
+	if (!(base = sys_map_guarded(size)))
+		die("abort: unable to map coroutine stack\n");
+
+	return (char *)base + page;
+}
+
+static void
+stack_dealloc(void *ptr, size_t size, void *)
+{
+	size_t page = sys_page_size();
+	void *base;
+
+	size = ((size + page - 1) / page + 1) * page;
+	base = (char *)ptr - page;
+
+	if (poolsz < LEN(pool)) {
+		sys_release(ptr, size - page);
+		pool[poolsz].base = base;
+		pool[poolsz++].size = size;
+	} else
+		sys_unmap(base, size);
+}
+
 static void
 coroutine_entry(struct mco_coro *self)
 {
 	struct coroutine *co = self->user_data;
 
-	co->entry(co);
+	if (co->entry)
+		co->entry(co);
+	else
+		while (!co->step(co))
+			coroutine_yield();
 }
 
-static inline struct coroutine *
+static void
+coroutine_create(struct coroutine *co)
+{
+	struct mco_desc desc;
+	int rc;
+
+	desc = mco_desc_init(coroutine_entry, co->stack);
+	desc.alloc_cb = stack_alloc;
+	desc.dealloc_cb = stack_dealloc;
+	desc.user_data = co;
+
+	if ((rc = mco_create(&co->handle, &desc)) != MCO_SUCCESS)
+		die("mco_create: %d\n", rc);
+}
+
+struct coroutine *
 coroutine_self(void)
 {
 	return mco_running()->user_data;
@@ -53,30 +246,30 @@ void
 coroutine_init(struct coroutine *co)
 {
 	assert(co);
-	assert(co->entry);
+	assert(co->entry || co->step);
+	assert(co->prio < COROUTINE_PRIO_LAST);
 
-	struct coroutine **slot = NULL;
-	struct mco_desc desc;
-	int rc;
+	co->handle = NULL;
+	co->line = 0;
+	co->wait = COROUTINE_WAIT_NONE;
 
-	desc = mco_desc_init(coroutine_entry, 0);
-	desc.user_data = co;
+	/* Only events received from now on are of interest. */
+	co->input = stris.inputs_count;
 
-	if ((rc = mco_create(&co->handle, &desc)) != MCO_SUCCESS)
-		die("mco_create: %d\n", rc);
+	/* Step functions are called directly when stackless. */
+	if (co->entry || !STACKLESS)
+		coroutine_create(co);
 
-	/* register in stris stage */
-	for (size_t i = 0; i < LEN(stris.coroutines); ++i) {
-		if (stris.coroutines[i] == NULL) {
-			slot = &stris.coroutines[i];
-			break;
-		}
-	}
+	/* register in its class */
+	co->prev = sched.classes[co->prio].last;
+	co->next = NULL;
 
-	if (!slot)
-		die("abort: coroutine space exceeded\n");
+	if (co->prev)
+		co->prev->next = co;
+	else
+		sched.classes[co->prio].first = co;
 
-	*slot = co;
+	sched.classes[co->prio].last = co;
 }
 
 void
@@ -87,11 +280,65 @@ coroutine_sleep(unsigned int ms)
 	struct coroutine *co;
 
 	co = coroutine_self();
-	co->delay_for = ms;
-	co->delay_acc = 0;
+	coroutine_arm(co, ms);
+	coroutine_yield();
+}
 
-	while (co->delay_acc < co->delay_for)
+void
+coroutine_arm(struct coroutine *co, unsigned int ms)
+{
+	assert(co);
+	assert(ms);
+	assert(co->wait == COROUTINE_WAIT_NONE);
+
+	co->delay = ms;
+	co->wake = sched.now + ms;
+	co->wait = COROUTINE_WAIT_SLEEP;
+	heap_push(co);
+}
+
+void
+coroutine_wait_input(void)
+{
+	struct coroutine *co;
+
+	co = coroutine_self();
+
+	if (co->input == stris.inputs_count) {
+		co->wait = COROUTINE_WAIT_INPUT;
 		coroutine_yield();
+	}
+}
+
+void
+coroutine_notify_input(void)
+{
+	for (size_t i = 0; i < LEN(sched.classes); ++i)
+		for (struct coroutine *co = sched.classes[i].first; co; co = co->next)
+			if (co->wait == COROUTINE_WAIT_INPUT)
+				co->wait = COROUTINE_WAIT_NONE;
+}
+
+void
+coroutine_pause(struct coroutine *co, int pause)
+{
+	assert(co);
+
+	if (!co->pause == !pause)
+		return;
+
+	/* Only the time left is kept while paused. */
+	if (co->wait == COROUTINE_WAIT_SLEEP) {
+		if (pause) {
+			heap_remove(co);
+			co->wake = co->wake > sched.now ? co->wake - sched.now : 0;
+		} else {
+			co->wake += sched.now;
+			heap_push(co);
+		}
+	}
+
+	co->pause = pause;
 }
 
 void
@@ -99,7 +346,15 @@ coroutine_rearm(struct coroutine *co)
 {
 	assert(co);
 
-	co->delay_acc = 0;
+	if (co->wait != COROUTINE_WAIT_SLEEP)
+		return;
+
+	if (co->pause)
+		co->wake = co->delay;
+	else {
+		co->wake = sched.now + co->delay;
+		heap_fix(co);
+	}
 }
 
 void
@@ -107,30 +362,67 @@ coroutine_cancel(struct coroutine *co)
 {
 	assert(co);
 
-	co->delay_for = co->delay_acc;
+	if (co->wait != COROUTINE_WAIT_SLEEP)
+		return;
+
+	if (co->pause)
+		co->wake = 0;
+	else {
+		co->wake = sched.now;
+		heap_fix(co);
+	}
 }
 
-int
-coroutine_resume(struct coroutine *co, unsigned int dt)
+static void
+coroutine_dispatch(enum coroutine_prio prio)
 {
-	assert(co);
+	struct coroutine *co;
+	int rc, done;
 
-	int rc, resume = 0;
+	/*
+	 * A coroutine may destroy others, including the next one, those it
+	 * creates in the same class wait for the next frame.
+	 */
+	for (co = sched.classes[prio].first; co; co = sched.next) {
+		sched.next = co->next;
 
-	if (co->delay_for) {
-		co->delay_acc += dt;
+		if (co->pause || co->wait)
+			continue;
 
-		if (co->delay_acc >= co->delay_for) {
-			co->delay_for = co->delay_acc = 0;
-			resume = 1;
-		}
-	} else
-		resume = 1;
+		if (co->handle) {
+			if ((rc = mco_resume(co->handle)) != MCO_SUCCESS)
+				die("mco_resume: %d\n", rc);
 
-	if (resume && (rc = mco_resume(co->handle)) != MCO_SUCCESS)
-		die("mco_resume: %d\n", rc);
+			done = mco_status(co->handle) == MCO_DEAD;
+		} else
+			done = co->step(co);
 
-	return mco_status(co->handle) == MCO_DEAD;
+		if (done)
+			coroutine_finish(co);
+	}
+
+	sched.next = NULL;
+}
+
+void
+coroutine_run(unsigned int dt, uint64_t deadline)
+{
+	struct coroutine *co;
+
+	sched.now += dt;
+
+	while (sched.sleepersz && sched.sleepers[0]->wake <= sched.now) {
+		co = sched.sleepers[0];
+		heap_remove(co);
+		co->wait = COROUTINE_WAIT_NONE;
+	}
+
+	for (int prio = 0; prio < COROUTINE_PRIO_LAST; ++prio) {
+		if (prio == COROUTINE_PRIO_COSMETIC && SDL_GetTicksNS() > deadline)
+			break;
+
+		coroutine_dispatch(prio);
+	}
 }
 
 void
@@ -149,21 +441,31 @@ coroutine_finish(struct coroutine *co)
 
 	int rc;
 
-	if (!co->handle)
+	/* Not running, it is the first one of its class otherwise. */
+	if (!co->prev && sched.classes[co->prio].first != co)
 		return;
 
-	if ((rc = mco_destroy(co->handle)) != MCO_SUCCESS)
+	if (co->handle && (rc = mco_destroy(co->handle)) != MCO_SUCCESS)
 		die("mco_destroy: %d\n", rc);
 
-	/* Remove coroutine from stris. */
-	for (size_t i = 0; i < LEN(stris.coroutines); ++i) {
-		if (stris.coroutines[i] == co) {
-			stris.coroutines[i] = NULL;
-			break;
-		}
-	}
-
+	if (co->wait == COROUTINE_WAIT_SLEEP && !co->pause)
+		heap_remove(co);
+
+	/* Remove coroutine from its class. */
+	if (sched.next == co)
+		sched.next = co->next;
+	if (co->prev)
+		co->prev->next = co->next;
+	else
+		sched.classes[co->prio].first = co->next;
+	if (co->next)
+		co->next->prev = co->prev;
+	else
+		sched.classes[co->prio].last = co->prev;
+
+	co->prev = co->next = NULL;
 	co->handle = NULL;
+	co->wait = COROUTINE_WAIT_NONE;
 
 	if (co->terminate)
 		co->terminate(co);
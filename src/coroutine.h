@@ -24,8 +24,83 @@
  * \brief Coroutine support.
  */
 
+#include <stddef.h>
+#include <stdint.h>
+
 struct mco_coro;
 
+/**
+ * Default coroutine stack size in bytes, deep enough to render.
+ */
+#define COROUTINE_STACK_SIZE 524288
+
+/**
+ * Stack size in bytes for coroutines that do not call into the renderer.
+ */
+#define COROUTINE_STACK_SMALL 65536
+
+/**
+ * Start the body of a ::coroutine::step function.
+ *
+ * Between ::COROUTINE_BEGIN and ::COROUTINE_END the function may use
+ * ::COROUTINE_YIELD and ::COROUTINE_SLEEP, at most once per line. Local
+ * variables are lost at each of them and a switch statement must not enclose
+ * them.
+ */
+#define COROUTINE_BEGIN(Co)                                                     \
+        switch ((Co)->line) {                                                   \
+        case 0:
+
+/**
+ * Return from a ::coroutine::step function, it continues from here on the
+ * next frame.
+ */
+#define COROUTINE_YIELD(Co)                                                     \
+do {                                                                            \
+        (Co)->line = __LINE__;                                                  \
+        return 0;                                                               \
+        case __LINE__:;                                                         \
+} while (0)
+
+/**
+ * Return from a ::coroutine::step function, it continues from here once the
+ * given amount of milliseconds elapsed.
+ */
+#define COROUTINE_SLEEP(Co, Ms)                                                 \
+do {                                                                            \
+        coroutine_arm((Co), (Ms));                                              \
+        COROUTINE_YIELD(Co);                                                    \
+} while (0)
+
+/**
+ * End the body of a ::coroutine::step function, the coroutine terminates.
+ */
+#define COROUTINE_END(Co)                                                       \
+        }                                                                       \
+        return 1
+
+/**
+ * \enum coroutine_prio
+ * \brief Dispatch class, coroutines are resumed in this order every frame.
+ */
+enum coroutine_prio {
+	COROUTINE_PRIO_INPUT,       /*!< react to input events */
+	COROUTINE_PRIO_LOGIC,       /*!< game logic */
+	COROUTINE_PRIO_ANIMATION,   /*!< visual feedback */
+	COROUTINE_PRIO_COSMETIC,    /*!< skipped on late frames */
+	COROUTINE_PRIO_LAST         /*!< number of classes */
+};
+
+/**
+ * \enum coroutine_wait
+ * \brief What a coroutine is waiting for before being resumed.
+ */
+enum coroutine_wait {
+	COROUTINE_WAIT_NONE,    /*!< resumed on every frame */
+	COROUTINE_WAIT_SLEEP,   /*!< resumed once its deadline is reached */
+	COROUTINE_WAIT_INPUT    /*!< resumed once an input event arrives */
+};
+
 /**
  * \struct coroutine
  * \brief Coroutine object.
@@ -41,6 +116,18 @@ struct coroutine {
 	 */
 	void (*entry)(struct coroutine *self);
 
+	/**
+	 * (init)
+	 *
+	 * Alternative to ::coroutine::entry for simple coroutines, written with
+	 * ::COROUTINE_BEGIN and friends. It returns non-zero once terminated.
+	 *
+	 * When built with COROUTINE_STACKLESS it is called directly on the
+	 * main stack and must not use any other function that yields,
+	 * otherwise it runs on its own stack like any other coroutine.
+	 */
+	int (*step)(struct coroutine *self);
+
 	/**
 	 * (optional)
 	 *
@@ -54,15 +141,40 @@ struct coroutine {
 	/**
 	 * (optional)
 	 *
-	 * If non-zero, the coroutine is not resumed nor updated.
+	 * Dispatch class, ::COROUTINE_PRIO_INPUT if left to 0 so every
+	 * coroutine should set its own. Within a class coroutines are resumed
+	 * in registration order.
+	 */
+	enum coroutine_prio prio;
+
+	/**
+	 * (optional)
 	 *
-	 * This is useful for logic like pause.
+	 * Stack size in bytes, ::COROUTINE_STACK_SIZE if 0.
+	 *
+	 * Stacks are recycled once the coroutine is destroyed. On POSIX systems
+	 * their pages are only backed by memory as they are used, Windows
+	 * commits them up front.
+	 */
+	size_t stack;
+
+	/**
+	 * (read-only)
+	 *
+	 * If non-zero, the coroutine is not resumed nor updated, see
+	 * ::coroutine_pause.
 	 */
 	int pause;
 
-	struct mco_coro *handle;        /* minicoro handle */
-	unsigned int delay_acc;         /* coroutine_sleep accumulator */
-	unsigned int delay_for;         /* coroutine_sleep yield */
+	struct mco_coro *handle;        /* minicoro handle, NULL if stackless */
+	int line;                       /* step resume point */
+	enum coroutine_wait wait;       /* reason not to resume */
+	uint64_t wake;                  /* deadline or time left if paused */
+	unsigned int delay;             /* coroutine_sleep duration */
+	size_t heap;                    /* index in sleepers */
+	uint64_t input;                 /* next stris.inputs to read */
+	struct coroutine *prev;         /* previous in its class */
+	struct coroutine *next;         /* next in its class */
 };
 
 /**
@@ -76,11 +188,46 @@ coroutine_init(struct coroutine *co);
 /**
  * Yield the calling coroutine for the given amount of milliseconds.
  *
+ * The coroutine is not resumed at all in the meantime.
+ *
  * \param ms the time to sleep in milliseconds
  */
 void
 coroutine_sleep(unsigned int ms);
 
+/**
+ * Make the coroutine sleep for the given amount of milliseconds once it
+ * yields, this is the non-yielding part of ::coroutine_sleep.
+ *
+ * \param co the coroutine
+ * \param ms the time to sleep in milliseconds
+ */
+void
+coroutine_arm(struct coroutine *co, unsigned int ms);
+
+/**
+ * Yield the calling coroutine until an input event it did not read yet is
+ * available, returns immediately if there is already one.
+ */
+void
+coroutine_wait_input(void);
+
+/**
+ * Make every coroutine yielding in ::coroutine_wait_input ready again.
+ */
+void
+coroutine_notify_input(void);
+
+/**
+ * Suspend or continue a coroutine. Time spent paused does not count for a
+ * coroutine yielding in ::coroutine_sleep.
+ *
+ * \param co the coroutine
+ * \param pause non-zero to suspend
+ */
+void
+coroutine_pause(struct coroutine *co, int pause);
+
 /**
  * If a coroutine is yielding in ::coroutine_sleep, this function called from
  * another coroutine rearms its time to wait.
@@ -99,16 +246,23 @@ void
 coroutine_cancel(struct coroutine *co);
 
 /**
- * Resume the coroutine if one of the condition applies:
+ * Resume, by class then in registration order, every coroutine that is not
+ * paused and either:
+ *
+ * - yielding with ::coroutine_yield,
+ * - yielding in ::coroutine_sleep and whose deadline is reached,
+ * - yielding in ::coroutine_wait_input and notified since.
+ *
+ * Coroutines of class ::COROUTINE_PRIO_COSMETIC are left for the next frame
+ * if the deadline is already passed when their turn comes.
  *
- * - The coroutine is suspended (yielding).
- * - The coroutine is waiting (yielding in coroutine_sleep) and the total
- *   accumulated time has elapsed.
+ * Coroutines that terminate are destroyed with ::coroutine_finish.
  *
- * \param dt time difference since last frame
+ * \param dt time in milliseconds since last frame
+ * \param deadline the SDL time in nanoseconds the frame must be done by
  */
-int
-coroutine_resume(struct coroutine *co, unsigned int dt);
+void
+coroutine_run(unsigned int dt, uint64_t deadline);
 
 /**
  * Yield the calling coroutine.
@@ -116,6 +270,12 @@ coroutine_resume(struct coroutine *co, unsigned int dt);
 void
 coroutine_yield(void);
 
+/**
+ * Returns the calling coroutine.
+ */
+struct coroutine *
+coroutine_self(void);
+
 /**
  * Remove coroutine from stris main loop and destroy it.
  */
@@ -0,0 +1,414 @@
+/*
+ * game.c -- game rules
+ *
+ * Copyright (c) 2011-2026 David Demelier <markand@malikania.fr>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <assert.h>
+#include <string.h>
+
+#include "game.h"
+#include "util.h"
+
+/*
+ * Time in microseconds to fall by one row for every level.
+ *
+ * Levels 1 to 10 keep the original 900 - 74 * level milliseconds, then the
+ * speed increases geometrically up to 20 rows per 60 Hz frame (20G) at level
+ * 20 and stays there.
+ */
+static const unsigned int speeds[] = {
+	826000, 752000, 678000, 604000, 530000,
+	456000, 382000, 308000, 234000, 160000,
+	 94578,  55906,  33047,  19534,  11547,
+	  6826,   4035,   2385,   1410,    833
+};
+
+/*
+ * Minimum time in milliseconds a shape rests on the stack before locking.
+ */
+#define LOCK_DELAY_MIN 160
+
+/*
+ * One row in GAME_STATE_FALLING fixed point gravity.
+ */
+#define ROW (UINT64_C(1) << 32)
+
+/*
+ * Update gravity and lock delay for the current level.
+ */
+static void
+game_speed(struct game *g)
+{
+	unsigned int us;
+
+	us = speeds[(g->level > LEN(speeds) ? LEN(speeds) : g->level) - 1];
+
+	/* Rounded up so that a row is never late because of the precision. */
+	g->gravity = (ROW * 1000 + us - 1) / us;
+	g->lock_delay = us / 1000 > LOCK_DELAY_MIN ? us / 1000 : LOCK_DELAY_MIN;
+}
+
+/*
+ * Update the landing row of the current shape.
+ */
+static inline void
+game_ghost(struct game *g)
+{
+	g->ghost = board_drop(&g->board, &g->shape);
+}
+
+static enum game_event
+game_spawn(struct game *g)
+{
+	g->shape.k = queue_pop(&g->queue, &g->rng);
+	g->shape.o = 0;
+	g->shape.x = (g->board.w - 4) / 2;
+	g->shape.y = 0;
+	g->fall = 0;
+	g->timer = 0;
+
+	/* If we can't spawn, that's dead! */
+	if (!board_check(&g->board, &g->shape)) {
+		g->state = GAME_STATE_OVER;
+		return GAME_EVENT_OVER;
+	}
+
+	game_ghost(g);
+	g->state = GAME_STATE_FALLING;
+
+	return GAME_EVENT_SPAWN;
+}
+
+/*
+ * Place the shape in the board, look for the full lines it made and either
+ * start clearing them or go on with the next shape.
+ */
+static enum game_event
+game_lock(struct game *g)
+{
+	unsigned int count = 0;
+
+	board_set(&g->board, &g->shape);
+	g->timer = 0;
+
+	/* Only rows covered by the shape that just locked can be full. */
+	g->clearing = board_lines(&g->board, &g->shape);
+
+	for (uint64_t m = g->clearing; m; m &= m - 1)
+		count++;
+
+	if (!count)
+		return GAME_EVENT_LOCK | game_spawn(g);
+
+	g->lines += count;
+	g->level = (g->lines / 10) + 1;
+	g->state = GAME_STATE_CLEARING;
+	game_speed(g);
+
+	return GAME_EVENT_LOCK | GAME_EVENT_CLEAR;
+}
+
+static enum game_event
+game_move(struct game *g, int dx, int dy)
+{
+	struct shape shape = g->shape;
+
+	shape.x += dx;
+	shape.y += dy;
+
+	if (!board_check(&g->board, &shape))
+		return GAME_EVENT_NONE;
+
+	g->shape = shape;
+
+	/*
+	 * Going straight down keeps the same landing row but rearms the fall
+	 * and lock delays.
+	 */
+	if (dx)
+		game_ghost(g);
+	if (dy)
+		g->fall = g->timer = 0;
+
+	return GAME_EVENT_MOVE;
+}
+
+static enum game_event
+game_rotate(struct game *g)
+{
+	struct shape shape = g->shape;
+
+	shape_rotate(&shape, 1);
+
+	if (!board_check(&g->board, &shape))
+		return GAME_EVENT_NONE;
+
+	g->shape = shape;
+	game_ghost(g);
+
+	return GAME_EVENT_ROTATE;
+}
+
+static enum game_event
+game_drop(struct game *g)
+{
+	g->shape.y = g->ghost;
+
+	return GAME_EVENT_DROP | game_lock(g);
+}
+
+/*
+ * Apply gravity for dt milliseconds and return the time left once the shape
+ * rests on the stack. Falling to a lower row rearms the lock timer so that it
+ * always counts from the last landing.
+ *
+ * The landing row is already known so the shape goes down by as many rows as
+ * needed at once, at any speed.
+ */
+static unsigned int
+game_fall(struct game *g, unsigned int dt, enum game_event *ev)
+{
+	uint64_t need, rows;
+	unsigned int t;
+
+	if (g->shape.y >= g->ghost)
+		return dt;
+
+	need = (uint64_t)(g->ghost - g->shape.y) * ROW - g->fall;
+
+	/* Still in the air at the end of the step. */
+	if (dt < (need + g->gravity - 1) / g->gravity) {
+		g->fall += g->gravity * dt;
+		rows = g->fall / ROW;
+		g->fall %= ROW;
+
+		if (rows) {
+			g->shape.y += rows;
+			g->timer = 0;
+			*ev |= GAME_EVENT_MOVE;
+		}
+
+		return 0;
+	}
+
+	/* Landed during the step, the rest counts for the lock delay. */
+	t = (need + g->gravity - 1) / g->gravity;
+	g->shape.y = g->ghost;
+	g->fall = 0;
+	g->timer = 0;
+	*ev |= GAME_EVENT_MOVE;
+
+	return dt - t;
+}
+
+/*
+ * Return how much of dt can elapse before the next automatic shift so that
+ * it happens at its exact time even within a large step.
+ */
+static unsigned int
+game_span(const struct game *g, unsigned int dt)
+{
+	if (g->shift && g->shift_left && g->shift_left < dt)
+		return g->shift_left;
+
+	return dt;
+}
+
+/*
+ * Charge the direction held for t milliseconds, the charge is kept while
+ * there is no shape to move.
+ */
+static void
+game_charge(struct game *g, unsigned int t)
+{
+	if (g->shift)
+		g->shift_left = g->shift_left > t ? g->shift_left - t : 0;
+}
+
+/*
+ * Shift the shape if the direction held is charged. Without repeat rate the
+ * shape goes to the wall and stays charged so that it keeps sliding if the
+ * path opens while it falls.
+ */
+static enum game_event
+game_shift(struct game *g)
+{
+	enum game_event ev = GAME_EVENT_NONE;
+	int dx;
+
+	if (!g->shift || g->shift_left)
+		return ev;
+
+	dx = g->shift == GAME_INPUT_LEFT ? -1 : +1;
+
+	if ((g->shift_left = g->arr))
+		ev |= game_move(g, dx, 0);
+	else
+		while (game_move(g, dx, 0))
+			ev |= GAME_EVENT_MOVE;
+
+	return ev;
+}
+
+/*
+ * Track the direction to auto shift, the last one pressed wins and the other
+ * one takes over with a new delay when it is released.
+ */
+static void
+game_hold(struct game *g, enum game_input pressed, enum game_input released)
+{
+	enum game_input dir = GAME_INPUT_NONE;
+
+	if (!g->das)
+		return;
+
+	if (pressed & GAME_INPUT_LEFT)
+		dir = GAME_INPUT_LEFT;
+	else if (pressed & GAME_INPUT_RIGHT)
+		dir = GAME_INPUT_RIGHT;
+	else if (released & g->shift)
+		dir = g->held & (GAME_INPUT_LEFT | GAME_INPUT_RIGHT);
+	else
+		return;
+
+	g->shift = dir;
+	g->shift_left = g->das;
+}
+
+static enum game_event
+game_input(struct game *g, enum game_input pressed)
+{
+	enum game_event ev = GAME_EVENT_NONE;
+	int dx = 0, dy = 0;
+
+	if (pressed & GAME_INPUT_LEFT)
+		dx = -1;
+	else if (pressed & GAME_INPUT_RIGHT)
+		dx = +1;
+
+	if (pressed & GAME_INPUT_DOWN)
+		dy = 1;
+
+	if (dx || dy)
+		ev |= game_move(g, dx, dy);
+	if (pressed & GAME_INPUT_ROTATE)
+		ev |= game_rotate(g);
+	if (pressed & GAME_INPUT_DROP)
+		ev |= game_drop(g);
+
+	return ev;
+}
+
+void
+game_init(struct game *g)
+{
+	assert(g);
+	assert(g->rand >= SHAPE_RAND_STANDARD && g->rand <= SHAPE_RAND_MAX);
+
+	if (!g->w)
+		g->w = BOARD_W;
+	if (!g->h)
+		g->h = BOARD_H;
+
+	assert(g->garbage <= (unsigned int)g->h);
+
+	rng_seed(&g->rng, g->seed);
+	queue_init(&g->queue, g->randomizer, g->rand, &g->rng,
+	    g->lookahead ? g->lookahead : 1);
+
+	board_init(&g->board, g->w, g->h);
+
+	for (int r = g->h - g->garbage; r < g->h; ++r)
+		for (int c = 0; c < g->w; ++c)
+			if (rng_range(&g->rng, 2) == 0)
+				board_put(&g->board, c, r, rng_range(&g->rng, SHAPE_RAND_MAX));
+
+	g->level = 1;
+	g->lines = 0;
+	g->clearing = 0;
+	g->held = GAME_INPUT_NONE;
+	g->shift = GAME_INPUT_NONE;
+	g->shift_left = 0;
+	game_speed(g);
+
+	game_spawn(g);
+}
+
+enum game_event
+game_step(struct game *g, enum game_input inputs, unsigned int dt)
+{
+	assert(g);
+
+	enum game_event ev = GAME_EVENT_NONE;
+	enum game_input pressed, released;
+	unsigned int span;
+
+	pressed = inputs & ~g->held;
+	released = g->held & ~inputs;
+	g->held = inputs;
+
+	game_hold(g, pressed, released);
+
+	if (g->state == GAME_STATE_FALLING && pressed)
+		ev |= game_input(g, pressed);
+
+	/*
+	 * Consume the elapsed time, the remainder is carried from one state
+	 * to the next so that large steps give the same result as small ones.
+	 */
+	for (;;) {
+		switch (g->state) {
+		case GAME_STATE_FALLING:
+			/*
+			 * Shift first if charged and elapse the time up to the
+			 * next shift. The lock timer only runs while the shape
+			 * rests on the stack, sliding does not reset it but
+			 * falling to a lower row does.
+			 */
+			ev |= game_shift(g);
+			span = game_span(g, dt);
+			dt -= span;
+
+			if ((g->timer += game_fall(g, span, &ev)) >= g->lock_delay) {
+				span -= g->timer - g->lock_delay;
+				dt += g->timer - g->lock_delay;
+				game_charge(g, span);
+				ev |= game_lock(g);
+				break;
+			}
+
+			game_charge(g, span);
+
+			if (!dt)
+				return ev | game_shift(g);
+			break;
+		case GAME_STATE_CLEARING:
+			if ((g->timer += dt) < g->clear_delay) {
+				game_charge(g, dt);
+				return ev;
+			}
+
+			game_charge(g, dt - (g->timer - g->clear_delay));
+			dt = g->timer - g->clear_delay;
+			board_pop(&g->board, g->clearing);
+			g->clearing = 0;
+			ev |= game_spawn(g);
+			break;
+		default:
+			return ev;
+		}
+	}
+}
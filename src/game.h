@@ -0,0 +1,275 @@
+/*
+ * game.h -- game rules
+ *
+ * Copyright (c) 2011-2026 David Demelier <markand@malikania.fr>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef STRIS_GAME_H
+#define STRIS_GAME_H
+
+/**
+ * \file game.h
+ * \brief Game rules.
+ *
+ * This module is the whole game without any rendering, sound or timing: the
+ * caller advances it with ::game_step by giving the inputs held and the
+ * amount of time elapsed. It has no dependency on SDL and is built as the
+ * libstris-core library so that it can be driven at full speed by bots,
+ * replays or benchmarks.
+ */
+
+#include <stdint.h>
+
+#include "board.h"
+#include "queue.h"
+#include "rng.h"
+#include "shape.h"
+
+/**
+ * Default time in milliseconds spent on full lines before removing them.
+ */
+#define GAME_CLEAR_DELAY 800
+
+/**
+ * Default time in milliseconds a direction is held before auto shifting.
+ */
+#define GAME_DAS 170
+
+/**
+ * Default time in milliseconds between automatic shifts.
+ */
+#define GAME_ARR 50
+
+/**
+ * \enum game_input
+ * \brief Game inputs.
+ *
+ * Actions are taken on the transition from released to held.
+ */
+enum game_input : unsigned int {
+	GAME_INPUT_NONE,                /*!< no input */
+	GAME_INPUT_LEFT   = 1 << 0,     /*!< move left */
+	GAME_INPUT_RIGHT  = 1 << 1,     /*!< move right */
+	GAME_INPUT_DOWN   = 1 << 2,     /*!< move down */
+	GAME_INPUT_ROTATE = 1 << 3,     /*!< rotate clockwise */
+	GAME_INPUT_DROP   = 1 << 4      /*!< drop and lock */
+};
+
+/**
+ * \enum game_event
+ * \brief Events that happened during a step.
+ */
+enum game_event : unsigned int {
+	GAME_EVENT_NONE,                /*!< nothing happened */
+	GAME_EVENT_MOVE   = 1 << 0,     /*!< shape moved or fell */
+	GAME_EVENT_ROTATE = 1 << 1,     /*!< shape rotated */
+	GAME_EVENT_DROP   = 1 << 2,     /*!< shape dropped */
+	GAME_EVENT_LOCK   = 1 << 3,     /*!< shape locked in the board */
+	GAME_EVENT_CLEAR  = 1 << 4,     /*!< lines are being cleared */
+	GAME_EVENT_SPAWN  = 1 << 5,     /*!< new shape in play */
+	GAME_EVENT_OVER   = 1 << 6      /*!< game over */
+};
+
+/**
+ * \enum game_state
+ * \brief Game state.
+ */
+enum game_state {
+	GAME_STATE_FALLING,             /*!< current shape is falling */
+	GAME_STATE_CLEARING,            /*!< full lines are about to be removed */
+	GAME_STATE_OVER                 /*!< a new shape could not spawn */
+};
+
+/**
+ * \struct game
+ * \brief Game state.
+ */
+struct game {
+	/**
+	 * (init)
+	 *
+	 * Board dimensions, 0 for the default ::BOARD_W and ::BOARD_H.
+	 */
+	int w;
+	int h;
+
+	/**
+	 * (init)
+	 *
+	 * Shapes that can be generated.
+	 */
+	enum shape_rand rand;
+
+	/**
+	 * (init)
+	 *
+	 * Randomizer used for incoming shapes.
+	 */
+	enum queue_mode randomizer;
+
+	/**
+	 * (init)
+	 *
+	 * Number of incoming shapes known in advance, see ::queue_peek.
+	 */
+	unsigned int lookahead;
+
+	/**
+	 * (init)
+	 *
+	 * Number of bottom rows randomly filled at startup.
+	 */
+	unsigned int garbage;
+
+	/**
+	 * (init)
+	 *
+	 * Time in milliseconds spent in ::GAME_STATE_CLEARING.
+	 */
+	unsigned int clear_delay;
+
+	/**
+	 * (init)
+	 *
+	 * Time in milliseconds a direction is held before the shape shifts
+	 * automatically, 0 to move on new press only.
+	 */
+	unsigned int das;
+
+	/**
+	 * (init)
+	 *
+	 * Time in milliseconds between automatic shifts, 0 to shift to the
+	 * wall at once.
+	 */
+	unsigned int arr;
+
+	/**
+	 * (init)
+	 *
+	 * Random seed, the same seed and inputs always give the same game.
+	 */
+	uint64_t seed;
+
+	/**
+	 * (read-only)
+	 *
+	 * Current state.
+	 */
+	enum game_state state;
+
+	/**
+	 * (read-only)
+	 *
+	 * Current level and number of lines removed.
+	 */
+	unsigned int level;
+	unsigned int lines;
+
+	/**
+	 * (read-only)
+	 *
+	 * Game board with the shapes locked so far.
+	 */
+	struct board board;
+
+	/**
+	 * (read-only)
+	 *
+	 * Current shape and the row where it would land, the shape is only
+	 * placed in the board when it locks.
+	 */
+	struct shape shape;
+	int ghost;
+
+	/**
+	 * (read-only)
+	 *
+	 * Incoming shapes.
+	 */
+	struct queue queue;
+
+	/**
+	 * (read-only)
+	 *
+	 * Full lines removed at the end of ::GAME_STATE_CLEARING.
+	 */
+	uint64_t clearing;
+
+	/**
+	 * (read-only)
+	 *
+	 * Current gravity in rows per millisecond as a 32.32 fixed point
+	 * number and progress toward the next row in the same unit.
+	 */
+	uint64_t gravity;
+	uint64_t fall;
+
+	/**
+	 * (read-only)
+	 *
+	 * Time in milliseconds a shape rests on the stack before locking.
+	 */
+	unsigned int lock_delay;
+
+	/**
+	 * (read-only)
+	 *
+	 * Time in milliseconds spent on the stack in ::GAME_STATE_FALLING or
+	 * spent in ::GAME_STATE_CLEARING.
+	 */
+	unsigned int timer;
+
+	/**
+	 * (private)
+	 *
+	 * Direction held for automatic shifting and time left before its next
+	 * move.
+	 */
+	enum game_input shift;
+	unsigned int shift_left;
+
+	/**
+	 * (private)
+	 *
+	 * Inputs held at the previous step and random state.
+	 */
+	enum game_input held;
+	struct rng rng;
+};
+
+/**
+ * Initialize the game and spawn the first shape.
+ *
+ * All (init) fields must be set.
+ */
+void
+game_init(struct game *game);
+
+/**
+ * Advance the game.
+ *
+ * Inputs newly held are applied first, then the time is elapsed. A
+ * direction still held shifts the shape again as set by game::das and
+ * game::arr, at the exact time within the step.
+ *
+ * \param inputs the inputs currently held
+ * \param dt the time elapsed in milliseconds
+ * \return the bitmask of events that happened
+ */
+enum game_event
+game_step(struct game *game, enum game_input inputs, unsigned int dt);
+
+#endif /* !STRIS_GAME_H */
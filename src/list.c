@@ -53,7 +53,7 @@ static void
 setup(struct list *list)
 {
 	struct list_item *li;
-	struct texture texture;
+	struct texture texture = {};
 
 	for (size_t i = 0; i < list->itemsz; ++i) {
 		li = &list->items[i];
@@ -101,55 +101,57 @@ valign(struct list *l)
 		l->items[i].node.y = l->y + ystart + (((i + 1) * vspace) + (i * l->items[0].node.texture->h));
 }
 
-static void
-list_colorizer_entry(struct coroutine *self)
+static int
+list_colorizer_step(struct coroutine *self)
 {
 	struct list_item *li;
 	struct list *list;
-	uint32_t color, target;
 
 	list = LIST(self, colorizer);
 
-	color = UI_PALETTE_MENU_LOW;
-	target = UI_PALETTE_MENU_HIGH;
+	COROUTINE_BEGIN(self);
 
-	for (;;) {
-		if (list->readonly) {
-			coroutine_yield();
-			continue;
-		}
+	list->color = UI_PALETTE_MENU_LOW;
+	list->target = UI_PALETTE_MENU_HIGH;
 
-		coroutine_sleep(30);
+	for (;;) {
+		COROUTINE_SLEEP(self, 30);
 
 		/* Reached color target, change direction. */
-		if (color == target)
-			target = target == UI_PALETTE_MENU_HIGH ? UI_PALETTE_MENU_LOW : UI_PALETTE_MENU_HIGH;
+		if (list->color == list->target)
+			list->target = list->target == UI_PALETTE_MENU_HIGH ? UI_PALETTE_MENU_LOW : UI_PALETTE_MENU_HIGH;
 
-		color  = add(color, target, 24) << 24 |
-		         add(color, target, 16) << 16 |
-		         add(color, target, 8)  << 8;
-		color |= 0xff;
+		list->color  = add(list->color, list->target, 24) << 24 |
+		               add(list->color, list->target, 16) << 16 |
+		               add(list->color, list->target, 8)  << 8;
+		list->color |= 0xff;
 
 		for (size_t i = 0; i < list->itemsz; ++i) {
 			li = &list->items[i];
 
 			if (list->selection == i)
-				texture_color_blend(li->node.texture, color);
+				texture_color_blend(li->node.texture, list->color);
 			else
 				texture_color_blend(li->node.texture, UI_PALETTE_FG);
 		}
 	}
+
+	COROUTINE_END(self);
 }
 
 static void
-list_colorizer_terminate(struct coroutine *self)
+list_items_finish(struct list *list)
 {
-	struct list *list = LIST(self, colorizer);
-
 	for (size_t i = 0; i < list->itemsz; ++i)
 		node_finish(&list->items[i].node);
 }
 
+static void
+list_colorizer_terminate(struct coroutine *self)
+{
+	list_items_finish(LIST(self, colorizer));
+}
+
 static void
 list_selector_entry(struct coroutine *self)
 {
@@ -187,13 +189,18 @@ list_init(struct list *list)
 	halign(list);
 	valign(list);
 
-	/* Colorizer on selected items. */
-	list->colorizer.entry = list_colorizer_entry;
-	list->colorizer.terminate = list_colorizer_terminate;
-	coroutine_init(&list->colorizer);
+	/* Colorizer on selected items, nothing is selected if read-only. */
+	if (!list->readonly) {
+		list->colorizer.step = list_colorizer_step;
+		list->colorizer.terminate = list_colorizer_terminate;
+		list->colorizer.prio = COROUTINE_PRIO_ANIMATION;
+		coroutine_init(&list->colorizer);
+	}
 
 	/* Selector using keys. */
 	list->selector.entry = list_selector_entry;
+	list->selector.prio = COROUTINE_PRIO_INPUT;
+	list->selector.stack = COROUTINE_STACK_SMALL;
 	coroutine_init(&list->selector);
 }
 
@@ -224,5 +231,10 @@ list_finish(struct list *l)
 	assert(l);
 
 	coroutine_finish(&l->selector);
-	coroutine_finish(&l->colorizer);
+
+	/* The colorizer owns the items when it runs. */
+	if (l->readonly)
+		list_items_finish(l);
+	else
+		coroutine_finish(&l->colorizer);
 }
@@ -134,6 +134,8 @@ struct list {
 	unsigned int readonly;
 
 	size_t selection;               /* currently selected */
+	uint32_t color;                 /* selection color */
+	uint32_t target;                /* color to reach */
 	struct coroutine colorizer;     /* hover glower */
 	struct coroutine selector;      /* list selector */
 };
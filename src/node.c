@@ -30,21 +30,17 @@ node_init(struct node *node)
 	assert(node);
 	assert(node->texture);
 
-	struct node **slot = NULL;
-
 	node->own = 0;
+	node->prev = stris.nodes.last;
+	node->next = NULL;
 
-	for (size_t i = 0; i < LEN(stris.nodes); ++i) {
-		if (!stris.nodes[i]) {
-			slot = &stris.nodes[i];
-			break;
-		}
-	}
-
-	if (!slot)
-		die("abort: node space exceeded\n");
+	if (stris.nodes.last)
+		stris.nodes.last->next = node;
+	else
+		stris.nodes.first = node;
 
-	*slot = node;
+	stris.nodes.last = node;
+	stris.dirty = 1;
 }
 
 void
@@ -67,20 +63,49 @@ node_render(struct node *node)
 {
 	assert(node);
 
-	if (!node->hide)
+	node->drawn.texture = node->texture;
+	node->drawn.x = node->x;
+	node->drawn.y = node->y;
+	node->drawn.hide = node->hide;
+
+	if (node->hide)
+		return;
+
+	if (node->render)
+		node->render(node);
+	else
 		texture_render(node->texture, node->x, node->y);
 }
 
+int
+node_changed(const struct node *node)
+{
+	assert(node);
+
+	return node->texture != node->drawn.texture ||
+	       node->x != node->drawn.x ||
+	       node->y != node->drawn.y ||
+	       node->hide != node->drawn.hide;
+}
+
 void
 node_finish(struct node *node)
 {
 	assert(node);
 
-	for (size_t i = 0; i < LEN(stris.nodes); ++i) {
-		if (stris.nodes[i] == node) {
-			stris.nodes[i] = NULL;
-			break;
-		}
+	/* Only if registered, it is the first one otherwise. */
+	if (node->prev || stris.nodes.first == node) {
+		if (node->prev)
+			node->prev->next = node->next;
+		else
+			stris.nodes.first = node->next;
+		if (node->next)
+			node->next->prev = node->prev;
+		else
+			stris.nodes.last = node->prev;
+
+		node->prev = node->next = NULL;
+		stris.dirty = 1;
 	}
 
 	if (node->own) {
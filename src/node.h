@@ -59,8 +59,28 @@ struct node {
 	 */
 	int hide;
 
+	/**
+	 * (read-write, optional)
+	 *
+	 * Custom rendering function called instead of drawing the texture 1:1
+	 * at x;y.
+	 */
+	void (*render)(struct node *self);
+
 	/* Non-zero if texture is owned by node. */
 	int own;
+
+	/* State at the last frame, to tell if it changed. */
+	struct {
+		struct texture *texture;
+		int x;
+		int y;
+		int hide;
+	} drawn;
+
+	/* Siblings in stris.nodes. */
+	struct node *prev;
+	struct node *next;
 };
 
 /**
@@ -87,6 +107,15 @@ node_wrap(struct node *node, struct texture *texture);
 void
 node_render(struct node *node);
 
+/**
+ * Tell if the node moved, changed its texture or visibility since it was
+ * last rendered.
+ *
+ * \return non-zero if the node needs to be rendered again
+ */
+int
+node_changed(const struct node *node);
+
 /**
  * Remove node from stris main loop and destroy it.
  *
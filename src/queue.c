@@ -0,0 +1,178 @@
+/*
+ * queue.c -- incoming shapes queue
+ *
+ * Copyright (c) 2011-2026 David Demelier <markand@malikania.fr>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <assert.h>
+#include <string.h>
+
+#include "queue.h"
+#include "rng.h"
+#include "util.h"
+
+/* Standard kinds as laid out in the shape table. */
+#define KIND_O 0
+#define KIND_I 1
+#define KIND_S 2
+#define KIND_Z 3
+#define KIND_L 4
+#define KIND_J 5
+#define KIND_T 6
+
+/* Number of rolls for the history randomizer. */
+#define HISTORY_TRIES 6
+
+/*
+ * Draw the next standard shape from the bag, refilling it when empty. Drawing
+ * a random remaining entry is the same as an incremental Fisher-Yates
+ * shuffle.
+ */
+static int
+queue_bag(struct queue *q, struct rng *rng)
+{
+	size_t j;
+	int k;
+
+	if (q->bag_left == 0) {
+		for (size_t i = 0; i < LEN(q->bag); ++i)
+			q->bag[i] = i;
+
+		q->bag_left = LEN(q->bag);
+	}
+
+	j = rng_range(rng, q->bag_left);
+	k = q->bag[j];
+	q->bag[j] = q->bag[--q->bag_left];
+
+	return k;
+}
+
+/*
+ * Same as the bag but once it has been emptied, generate some random shapes
+ * as well. If we're being asked to put some !standard pieces, do it less often
+ * because they are very hard to positionate.
+ */
+static int
+queue_bag_extras(struct queue *q, struct rng *rng)
+{
+	if (q->bag_left == 0 && q->bag_extras) {
+		q->bag_extras--;
+
+		if (rng_range(rng, 4) == 0)
+			return rng_range(rng, q->rand);
+
+		return rng_range(rng, SHAPE_RAND_STANDARD);
+	}
+
+	if (q->bag_left == 0)
+		q->bag_extras = q->rand - SHAPE_RAND_STANDARD;
+
+	return queue_bag(q, rng);
+}
+
+static int
+queue_remember(struct queue *q, int k)
+{
+	memmove(&q->history[1], &q->history[0], sizeof (q->history) - 1);
+	q->history[0] = k;
+
+	return k;
+}
+
+static int
+queue_history(struct queue *q, struct rng *rng)
+{
+	int k = 0;
+
+	for (int t = 0; t < HISTORY_TRIES; ++t) {
+		k = rng_range(rng, q->rand);
+
+		if (!memchr(q->history, k, sizeof (q->history)))
+			break;
+	}
+
+	return queue_remember(q, k);
+}
+
+static int
+queue_generate(struct queue *q, struct rng *rng)
+{
+	switch (q->mode) {
+	case QUEUE_MODE_BAG:
+		return queue_bag(q, rng);
+	case QUEUE_MODE_HISTORY:
+		return queue_history(q, rng);
+	default:
+		return queue_bag_extras(q, rng);
+	}
+}
+
+void
+queue_init(struct queue *q,
+           enum queue_mode mode,
+           enum shape_rand r,
+           struct rng *rng,
+           size_t lookahead)
+{
+	assert(q);
+	assert(rng);
+	assert(lookahead >= 1 && lookahead <= QUEUE_MAX);
+
+	static const uint8_t firsts[] = { KIND_I, KIND_L, KIND_J, KIND_T };
+
+	memset(q, 0, sizeof (*q));
+	q->mode = mode;
+	q->rand = r;
+	q->lookahead = lookahead;
+
+	/*
+	 * The history starts with the snakes and the first piece is never
+	 * one of the hard ones to place on an empty board.
+	 */
+	q->history[0] = q->history[1] = KIND_Z;
+	q->history[2] = q->history[3] = KIND_S;
+
+	for (size_t i = 0; i < lookahead; ++i) {
+		if (i == 0 && mode == QUEUE_MODE_HISTORY)
+			q->ring[i] = queue_remember(q, firsts[rng_range(rng, LEN(firsts))]);
+		else
+			q->ring[i] = queue_generate(q, rng);
+	}
+}
+
+int
+queue_peek(const struct queue *q, size_t i)
+{
+	assert(q);
+	assert(i < q->lookahead);
+
+	return q->ring[(q->head + i) % QUEUE_MAX];
+}
+
+int
+queue_pop(struct queue *q, struct rng *rng)
+{
+	assert(q);
+	assert(rng);
+
+	int k;
+
+	k = q->ring[q->head];
+	q->ring[(q->head + q->lookahead) % QUEUE_MAX] = queue_generate(q, rng);
+	q->head = (q->head + 1) % QUEUE_MAX;
+
+	return k;
+}
@@ -0,0 +1,156 @@
+/*
+ * queue.h -- incoming shapes queue
+ *
+ * Copyright (c) 2011-2026 David Demelier <markand@malikania.fr>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef STRIS_QUEUE_H
+#define STRIS_QUEUE_H
+
+/**
+ * \file queue.h
+ * \brief Incoming shapes queue.
+ *
+ * The queue is a small ring buffer of shape kinds kept filled with a fixed
+ * number of pieces ahead. Every time a piece is taken out, exactly one new
+ * piece is generated by the selected randomizer so the cost is the same on
+ * every spawn.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "shape.h"
+
+struct rng;
+
+/**
+ * Maximum number of pieces that can be kept ahead.
+ */
+#define QUEUE_MAX 16
+
+/**
+ * \enum queue_mode
+ * \brief Randomizer used to generate the pieces.
+ */
+enum queue_mode {
+	/**
+	 * Every standard shape once in random order, followed by a few random
+	 * extra shapes when the range is larger than the standard set.
+	 *
+	 * This is the default stris randomizer.
+	 */
+	QUEUE_MODE_BAG_EXTRAS,
+
+	/**
+	 * Every standard shape once in random order, extra shapes are never
+	 * generated.
+	 *
+	 * See https://tetris.fandom.com/wiki/Random_Generator
+	 */
+	QUEUE_MODE_BAG,
+
+	/**
+	 * Roll a random shape, rolling again a few times if it is part of the
+	 * four last ones.
+	 *
+	 * See https://tetris.fandom.com/wiki/TGM_randomizer
+	 */
+	QUEUE_MODE_HISTORY
+};
+
+/**
+ * \struct queue
+ * \brief Queue state.
+ */
+struct queue {
+	/**
+	 * (read-only)
+	 *
+	 * Randomizer in use.
+	 */
+	enum queue_mode mode;
+
+	/**
+	 * (read-only)
+	 *
+	 * Shapes that can be generated.
+	 */
+	enum shape_rand rand;
+
+	/**
+	 * (read-only)
+	 *
+	 * Number of pieces available through ::queue_peek.
+	 */
+	size_t lookahead;
+
+	/**
+	 * (private)
+	 *
+	 * Ring of upcoming kinds and index of the first one.
+	 */
+	uint8_t ring[QUEUE_MAX];
+	size_t head;
+
+	/**
+	 * (private)
+	 *
+	 * Standard shapes not drawn yet from the current bag and number of
+	 * extras still to generate after it.
+	 */
+	uint8_t bag[SHAPE_RAND_STANDARD];
+	size_t bag_left;
+	size_t bag_extras;
+
+	/**
+	 * (private)
+	 *
+	 * Last generated kinds for the history randomizer.
+	 */
+	uint8_t history[4];
+};
+
+/**
+ * Initialize the queue and generate the first `lookahead` pieces.
+ *
+ * The queue does not keep the generator so that it can be copied freely, the
+ * same one must be passed to ::queue_pop.
+ *
+ * \pre lookahead >= 1 && lookahead <= QUEUE_MAX
+ */
+void
+queue_init(struct queue *queue,
+           enum queue_mode mode,
+           enum shape_rand r,
+           struct rng *rng,
+           size_t lookahead);
+
+/**
+ * Return the kind of the upcoming piece at position `i`, 0 being the next
+ * one.
+ *
+ * \pre i < queue->lookahead
+ */
+int
+queue_peek(const struct queue *queue, size_t i);
+
+/**
+ * Take the next piece out of the queue and generate a new one at the end.
+ */
+int
+queue_pop(struct queue *queue, struct rng *rng);
+
+#endif /* !STRIS_QUEUE_H */
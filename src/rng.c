@@ -0,0 +1,113 @@
+/*
+ * rng.c -- pseudo random number generator
+ *
+ * Copyright (c) 2011-2026 David Demelier <markand@malikania.fr>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <assert.h>
+#include <stdlib.h>
+#include <time.h>
+
+// For rng_entropy()
+#if defined(__linux__)
+#      include <sys/random.h>
+#endif
+
+#include "rng.h"
+
+static inline uint64_t
+rng_rotl(uint64_t x, int k)
+{
+	return (x << k) | (x >> (64 - k));
+}
+
+/*
+ * Expand the seed into the xoshiro state, as recommended by its authors so
+ * that even poor seeds (like 0) give a well mixed state.
+ */
+static inline uint64_t
+rng_splitmix(uint64_t *x)
+{
+	uint64_t z;
+
+	z = (*x += 0x9e3779b97f4a7c15ULL);
+	z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+
+	return z ^ (z >> 31);
+}
+
+void
+rng_seed(struct rng *rng, uint64_t seed)
+{
+	assert(rng);
+
+	uint64_t x = seed;
+
+	rng->seed = seed;
+
+	for (int i = 0; i < 4; ++i)
+		rng->s[i] = rng_splitmix(&x);
+}
+
+uint64_t
+rng_entropy(void)
+{
+	uint64_t seed = 0;
+
+#if defined(__linux__)
+	if (getrandom(&seed, sizeof (seed), 0) != sizeof (seed))
+		seed = (uint64_t)time(NULL) ^ (uint64_t)clock() << 32;
+#elif defined(__OpenBSD__) || defined(__FreeBSD__) || defined(__NetBSD__) || defined(__APPLE__)
+	arc4random_buf(&seed, sizeof (seed));
+#else
+	seed = (uint64_t)time(NULL) ^ (uint64_t)clock() << 32;
+#endif
+
+	return seed;
+}
+
+uint64_t
+rng_next(struct rng *rng)
+{
+	assert(rng);
+
+	uint64_t *s = rng->s, ret, t;
+
+	ret = rng_rotl(s[1] * 5, 7) * 9;
+	t = s[1] << 17;
+
+	s[2] ^= s[0];
+	s[3] ^= s[1];
+	s[1] ^= s[2];
+	s[0] ^= s[3];
+	s[2] ^= t;
+	s[3] = rng_rotl(s[3], 45);
+
+	return ret;
+}
+
+unsigned int
+rng_range(struct rng *rng, unsigned int n)
+{
+	assert(rng);
+	assert(n);
+
+	/*
+	 * Multiply the upper 32 bits by the range instead of using a modulo,
+	 * the bias is negligible for the tiny ranges used by the game.
+	 */
+	return (unsigned int)(((rng_next(rng) >> 32) * n) >> 32);
+}
@@ -0,0 +1,82 @@
+/*
+ * rng.h -- pseudo random number generator
+ *
+ * Copyright (c) 2011-2026 David Demelier <markand@malikania.fr>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef STRIS_RNG_H
+#define STRIS_RNG_H
+
+/**
+ * \file rng.h
+ * \brief Pseudo random number generator.
+ *
+ * This is a xoshiro256** generator, its whole state is kept in a small
+ * structure so that a game can be replayed identically from the seed it was
+ * started with.
+ */
+
+#include <stdint.h>
+
+/**
+ * \struct rng
+ * \brief Generator state.
+ */
+struct rng {
+	/**
+	 * (read-only)
+	 *
+	 * Seed the generator was initialized with.
+	 */
+	uint64_t seed;
+
+	/**
+	 * (private)
+	 *
+	 * Internal xoshiro256** state.
+	 */
+	uint64_t s[4];
+};
+
+/**
+ * Initialize the generator from a 64-bit seed.
+ *
+ * The same seed always produces the same sequence.
+ */
+void
+rng_seed(struct rng *rng, uint64_t seed);
+
+/**
+ * Return a seed suitable for ::rng_seed from the system entropy source.
+ *
+ * This function may perform a system call and is meant to be called only
+ * once per game.
+ */
+uint64_t
+rng_entropy(void);
+
+/**
+ * Generate the next 64-bit value.
+ */
+uint64_t
+rng_next(struct rng *rng);
+
+/**
+ * Generate a value in range 0..n (n excluded).
+ */
+unsigned int
+rng_range(struct rng *rng, unsigned int n);
+
+#endif /* !STRIS_RNG_H */
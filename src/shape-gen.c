@@ -0,0 +1,422 @@
+/*
+ * shape-gen.c -- generate shape geometry table
+ *
+ * Copyright (c) 2011-2026 David Demelier <markand@malikania.fr>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * This program is run at build time to turn the human readable shape
+ * definitions into the compact geometry table used by shape.c, see the
+ * shape_info structure in shape.h.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "util.h"
+
+static const int shapes[][4][4][4] = {
+	// {{{ Standard
+
+	// Rotation is based on SRS.
+	// https://tetris.fandom.com/wiki/SRS
+	{
+		{
+			{ 0, 1, 1, 0 },
+			{ 0, 1, 1, 0 },
+			{ 0, 0, 0, 0 },
+			{ 0, 0, 0, 0 }
+		},
+		{
+			{ 0, 1, 1, 0 },
+			{ 0, 1, 1, 0 },
+			{ 0, 0, 0, 0 },
+			{ 0, 0, 0, 0 }
+		},
+		{
+			{ 0, 1, 1, 0 },
+			{ 0, 1, 1, 0 },
+			{ 0, 0, 0, 0 },
+			{ 0, 0, 0, 0 }
+		},
+		{
+			{ 0, 1, 1, 0 },
+			{ 0, 1, 1, 0 },
+			{ 0, 0, 0, 0 },
+			{ 0, 0, 0, 0 }
+		}
+	},
+
+	{
+		{
+			{ 1, 1, 1, 1 },
+			{ 0, 0, 0, 0 },
+			{ 0, 0, 0, 0 },
+			{ 0, 0, 0, 0 },
+		},
+		{
+			{ 0, 0, 1, 0 },
+			{ 0, 0, 1, 0 },
+			{ 0, 0, 1, 0 },
+			{ 0, 0, 1, 0 }
+		},
+		{
+			{ 1, 1, 1, 1 },
+			{ 0, 0, 0, 0 },
+			{ 0, 0, 0, 0 },
+			{ 0, 0, 0, 0 },
+		},
+		{
+			{ 0, 0, 1, 0 },
+			{ 0, 0, 1, 0 },
+			{ 0, 0, 1, 0 },
+			{ 0, 0, 1, 0 }
+		}
+	},
+
+	{
+		{
+			{ 0, 0, 1, 1 },
+			{ 0, 1, 1, 0 },
+			{ 0, 0, 0, 0 },
+			{ 0, 0, 0, 0 }
+		},
+		{
+			{ 0, 0, 1, 0 },
+			{ 0, 0, 1, 1 },
+			{ 0, 0, 0, 1 },
+			{ 0, 0, 0, 0 }
+		},
+		{
+			{ 0, 0, 0, 0 },
+			{ 0, 0, 1, 1 },
+			{ 0, 1, 1, 0 },
+			{ 0, 0, 0, 0 }
+		},
+		{
+			{ 0, 1, 0, 0 },
+			{ 0, 1, 1, 0 },
+			{ 0, 0, 1, 0 },
+			{ 0, 0, 0, 0 }
+		}
+	},
+
+	{
+		{
+			{ 0, 1, 1, 0 },
+			{ 0, 0, 1, 1 },
+			{ 0, 0, 0, 0 },
+			{ 0, 0, 0, 0 }
+		},
+		{
+			{ 0, 0, 0, 1 },
+			{ 0, 0, 1, 1 },
+			{ 0, 0, 1, 0 },
+			{ 0, 0, 0, 0 }
+		},
+		{
+			{ 0, 0, 0, 0 },
+			{ 0, 1, 1, 0 },
+			{ 0, 0, 1, 1 },
+			{ 0, 0, 0, 0 }
+		},
+		{
+			{ 0, 0, 1, 0 },
+			{ 0, 1, 1, 0 },
+			{ 0, 1, 0, 0 },
+			{ 0, 0, 0, 0 }
+		},
+	},
+
+	{
+		{
+			{ 0, 0, 0, 1 },
+			{ 0, 1, 1, 1 },
+			{ 0, 0, 0, 0 },
+			{ 0, 0, 0, 0 }
+		},
+		{
+			{ 0, 0, 1, 0 },
+			{ 0, 0, 1, 0 },
+			{ 0, 0, 1, 1 },
+			{ 0, 0, 0, 0 }
+		},
+		{
+			{ 0, 0, 0, 0 },
+			{ 0, 1, 1, 1 },
+			{ 0, 1, 0, 0 },
+			{ 0, 0, 0, 0 }
+		},
+		{
+			{ 0, 1, 1, 0 },
+			{ 0, 0, 1, 0 },
+			{ 0, 0, 1, 0 },
+			{ 0, 0, 0, 0 }
+		}
+	},
+
+	{
+		{
+			{ 0, 1, 0, 0 },
+			{ 0, 1, 1, 1 },
+			{ 0, 0, 0, 0 },
+			{ 0, 0, 0, 0 }
+		},
+		{
+			{ 0, 0, 1, 1 },
+			{ 0, 0, 1, 0 },
+			{ 0, 0, 1, 0 },
+			{ 0, 0, 0, 0 }
+		},
+		{
+			{ 0, 0, 0, 0 },
+			{ 0, 1, 1, 1 },
+			{ 0, 0, 0, 1 },
+			{ 0, 0, 0, 0 }
+		},
+		{
+			{ 0, 0, 1, 0 },
+			{ 0, 0, 1, 0 },
+			{ 0, 1, 1, 0 },
+			{ 0, 0, 0, 0 }
+		}
+	},
+
+	{
+		{
+			{ 0, 0, 1, 0 },
+			{ 0, 1, 1, 1 },
+			{ 0, 0, 0, 0 },
+			{ 0, 0, 0, 0 }
+		},
+		{
+			{ 0, 0, 1, 0 },
+			{ 0, 0, 1, 1 },
+			{ 0, 0, 1, 0 },
+			{ 0, 0, 0, 0 }
+		},
+		{
+			{ 0, 0, 0, 0 },
+			{ 0, 1, 1, 1 },
+			{ 0, 0, 1, 0 },
+			{ 0, 0, 0, 0 },
+		},
+		{
+			{ 0, 0, 1, 0 },
+			{ 0, 1, 1, 0 },
+			{ 0, 0, 1, 0 },
+			{ 0, 0, 0, 0 }
+		}
+	},
+	// }}}
+
+	// {{{ Extended.
+	{
+		{
+			{ 0, 0, 0, 1 },
+			{ 0, 1, 1, 1 },
+			{ 0, 1, 0, 0 },
+			{ 0, 0, 0, 0 },
+		},
+		{
+			{ 0, 1, 1, 0 },
+			{ 0, 0, 1, 0 },
+			{ 0, 0, 1, 1 },
+			{ 0, 0, 0, 0 }
+		},
+		{
+			{ 0, 0, 0, 1 },
+			{ 0, 1, 1, 1 },
+			{ 0, 1, 0, 0 },
+			{ 0, 0, 0, 0 },
+		},
+		{
+			{ 0, 1, 1, 0 },
+			{ 0, 0, 1, 0 },
+			{ 0, 0, 1, 1 },
+			{ 0, 0, 0, 0 }
+		}
+	},
+
+	{
+		{
+			{ 0, 1, 1, 0 },
+			{ 0, 0, 1, 1 },
+			{ 0, 0, 0, 1 },
+			{ 0, 0, 0, 0 }
+		},
+		{
+			{ 0, 0, 0, 1 },
+			{ 0, 0, 1, 1 },
+			{ 0, 1, 1, 0 },
+			{ 0, 0, 0, 0 }
+		},
+		{
+			{ 0, 1, 0, 0 },
+			{ 0, 1, 1, 0 },
+			{ 0, 0, 1, 1 },
+			{ 0, 0, 0, 0 }
+		},
+		{
+			{ 0, 0, 1, 1 },
+			{ 0, 1, 1, 0 },
+			{ 0, 1, 0, 0 },
+			{ 0, 0, 0, 0 }
+		}
+	},
+
+	{
+		{
+			{ 0, 1, 1, 1 },
+			{ 1, 1, 1, 0 },
+			{ 0, 0, 0, 0 },
+			{ 0, 0, 0, 0 }
+		},
+		{
+			{ 0, 1, 0, 0 },
+			{ 0, 1, 1, 0 },
+			{ 0, 1, 1, 0 },
+			{ 0, 0, 1, 0 }
+		},
+		{
+			{ 0, 1, 1, 1 },
+			{ 1, 1, 1, 0 },
+			{ 0, 0, 0, 0 },
+			{ 0, 0, 0, 0 }
+		},
+		{
+			{ 0, 1, 0, 0 },
+			{ 0, 1, 1, 0 },
+			{ 0, 1, 1, 0 },
+			{ 0, 0, 1, 0 }
+		},
+	},
+	// }}}
+
+	// {{{ Nightmare
+	{
+		{
+			{ 0, 0, 1, 0 },
+			{ 0, 1, 1, 1 },
+			{ 0, 0, 1, 0 },
+			{ 0, 0, 0, 0 },
+		},
+		{
+			{ 0, 0, 1, 0 },
+			{ 0, 1, 1, 1 },
+			{ 0, 0, 1, 0 },
+			{ 0, 0, 0, 0 },
+		},
+		{
+			{ 0, 0, 1, 0 },
+			{ 0, 1, 1, 1 },
+			{ 0, 0, 1, 0 },
+			{ 0, 0, 0, 0 },
+		},
+		{
+			{ 0, 0, 1, 0 },
+			{ 0, 1, 1, 1 },
+			{ 0, 0, 1, 0 },
+			{ 0, 0, 0, 0 },
+		},
+	},
+
+	{
+		{
+			{ 0, 1, 1, 1 },
+			{ 0, 1, 0, 1 },
+			{ 0, 1, 1, 1 },
+			{ 0, 0, 0, 0 },
+		},
+		{
+			{ 0, 1, 1, 1 },
+			{ 0, 1, 0, 1 },
+			{ 0, 1, 1, 1 },
+			{ 0, 0, 0, 0 },
+		},
+		{
+			{ 0, 1, 1, 1 },
+			{ 0, 1, 0, 1 },
+			{ 0, 1, 1, 1 },
+			{ 0, 0, 0, 0 },
+		},
+		{
+			{ 0, 1, 1, 1 },
+			{ 0, 1, 0, 1 },
+			{ 0, 1, 1, 1 },
+			{ 0, 0, 0, 0 },
+		},
+	},
+	// }}}
+};
+
+static void
+generate(const int def[4][4], int last)
+{
+	unsigned int cells = 0, rows[4] = {}, bottom[4] = {};
+	int cmin = 4, cmax = -1, rmin = 4, rmax = -1;
+
+	for (int r = 0; r < 4; ++r) {
+		for (int c = 0; c < 4; ++c) {
+			if (!def[r][c])
+				continue;
+
+			cells |= 1U << (r * 4 + c);
+			rows[r] |= 1U << c;
+			bottom[c] = r + 1;
+			cmin = c < cmin ? c : cmin;
+			cmax = c > cmax ? c : cmax;
+			rmin = r < rmin ? r : rmin;
+			rmax = r > rmax ? r : rmax;
+		}
+	}
+
+	if (cmax < 0) {
+		fprintf(stderr, "abort: empty shape definition\n");
+		exit(1);
+	}
+
+	printf("\t\t{\n");
+	printf("\t\t\t.cells = 0x%04x,\n", cells);
+	printf("\t\t\t.rows = { 0x%x, 0x%x, 0x%x, 0x%x },\n",
+	    rows[0], rows[1], rows[2], rows[3]);
+	printf("\t\t\t.bottom = { %u, %u, %u, %u },\n",
+	    bottom[0], bottom[1], bottom[2], bottom[3]);
+	printf("\t\t\t.x = %d,\n", cmin);
+	printf("\t\t\t.y = %d,\n", rmin);
+	printf("\t\t\t.w = %d,\n", cmax - cmin + 1);
+	printf("\t\t\t.h = %d\n", rmax - rmin + 1);
+	printf("\t\t}%s\n", last ? "" : ",");
+}
+
+int
+main(void)
+{
+	printf("/* Generated by shape-gen, do not edit. */\n\n");
+	printf("const struct shape_info shape_infos[%zu][4] = {\n", LEN(shapes));
+
+	for (size_t k = 0; k < LEN(shapes); ++k) {
+		printf("\t{\n");
+
+		for (int o = 0; o < 4; ++o)
+			generate(shapes[k][o], o == 3);
+
+		printf("\t}%s\n", k + 1 != LEN(shapes) ? "," : "");
+	}
+
+	printf("};\n");
+
+	return 0;
+}
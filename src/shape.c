@@ -23,358 +23,16 @@
 #include "shape.h"
 #include "util.h"
 
-static const int shapes[][4][4][4] = {
-	// {{{ Standard
+#include "shape-table.h"
 
-	// Rotation is based on SRS.
-	// https://tetris.fandom.com/wiki/SRS
-	{
-		{
-			{ 0, 1, 1, 0 },
-			{ 0, 1, 1, 0 },
-			{ 0, 0, 0, 0 },
-			{ 0, 0, 0, 0 }
-		},
-		{
-			{ 0, 1, 1, 0 },
-			{ 0, 1, 1, 0 },
-			{ 0, 0, 0, 0 },
-			{ 0, 0, 0, 0 }
-		},
-		{
-			{ 0, 1, 1, 0 },
-			{ 0, 1, 1, 0 },
-			{ 0, 0, 0, 0 },
-			{ 0, 0, 0, 0 }
-		},
-		{
-			{ 0, 1, 1, 0 },
-			{ 0, 1, 1, 0 },
-			{ 0, 0, 0, 0 },
-			{ 0, 0, 0, 0 }
-		}
-	},
-
-	{
-		{
-			{ 1, 1, 1, 1 },
-			{ 0, 0, 0, 0 },
-			{ 0, 0, 0, 0 },
-			{ 0, 0, 0, 0 },
-		},
-		{
-			{ 0, 0, 1, 0 },
-			{ 0, 0, 1, 0 },
-			{ 0, 0, 1, 0 },
-			{ 0, 0, 1, 0 }
-		},
-		{
-			{ 1, 1, 1, 1 },
-			{ 0, 0, 0, 0 },
-			{ 0, 0, 0, 0 },
-			{ 0, 0, 0, 0 },
-		},
-		{
-			{ 0, 0, 1, 0 },
-			{ 0, 0, 1, 0 },
-			{ 0, 0, 1, 0 },
-			{ 0, 0, 1, 0 }
-		}
-	},
-
-	{
-		{
-			{ 0, 0, 1, 1 },
-			{ 0, 1, 1, 0 },
-			{ 0, 0, 0, 0 },
-			{ 0, 0, 0, 0 }
-		},
-		{
-			{ 0, 0, 1, 0 },
-			{ 0, 0, 1, 1 },
-			{ 0, 0, 0, 1 },
-			{ 0, 0, 0, 0 }
-		},
-		{
-			{ 0, 0, 0, 0 },
-			{ 0, 0, 1, 1 },
-			{ 0, 1, 1, 0 },
-			{ 0, 0, 0, 0 }
-		},
-		{
-			{ 0, 1, 0, 0 },
-			{ 0, 1, 1, 0 },
-			{ 0, 0, 1, 0 },
-			{ 0, 0, 0, 0 }
-		}
-	},
-
-	{
-		{
-			{ 0, 1, 1, 0 },
-			{ 0, 0, 1, 1 },
-			{ 0, 0, 0, 0 },
-			{ 0, 0, 0, 0 }
-		},
-		{
-			{ 0, 0, 0, 1 },
-			{ 0, 0, 1, 1 },
-			{ 0, 0, 1, 0 },
-			{ 0, 0, 0, 0 }
-		},
-		{
-			{ 0, 0, 0, 0 },
-			{ 0, 1, 1, 0 },
-			{ 0, 0, 1, 1 },
-			{ 0, 0, 0, 0 }
-		},
-		{
-			{ 0, 0, 1, 0 },
-			{ 0, 1, 1, 0 },
-			{ 0, 1, 0, 0 },
-			{ 0, 0, 0, 0 }
-		},
-	},
-
-	{
-		{
-			{ 0, 0, 0, 1 },
-			{ 0, 1, 1, 1 },
-			{ 0, 0, 0, 0 },
-			{ 0, 0, 0, 0 }
-		},
-		{
-			{ 0, 0, 1, 0 },
-			{ 0, 0, 1, 0 },
-			{ 0, 0, 1, 1 },
-			{ 0, 0, 0, 0 }
-		},
-		{
-			{ 0, 0, 0, 0 },
-			{ 0, 1, 1, 1 },
-			{ 0, 1, 0, 0 },
-			{ 0, 0, 0, 0 }
-		},
-		{
-			{ 0, 1, 1, 0 },
-			{ 0, 0, 1, 0 },
-			{ 0, 0, 1, 0 },
-			{ 0, 0, 0, 0 }
-		}
-	},
-
-	{
-		{
-			{ 0, 1, 0, 0 },
-			{ 0, 1, 1, 1 },
-			{ 0, 0, 0, 0 },
-			{ 0, 0, 0, 0 }
-		},
-		{
-			{ 0, 0, 1, 1 },
-			{ 0, 0, 1, 0 },
-			{ 0, 0, 1, 0 },
-			{ 0, 0, 0, 0 }
-		},
-		{
-			{ 0, 0, 0, 0 },
-			{ 0, 1, 1, 1 },
-			{ 0, 0, 0, 1 },
-			{ 0, 0, 0, 0 }
-		},
-		{
-			{ 0, 0, 1, 0 },
-			{ 0, 0, 1, 0 },
-			{ 0, 1, 1, 0 },
-			{ 0, 0, 0, 0 }
-		}
-	},
-
-	{
-		{
-			{ 0, 0, 1, 0 },
-			{ 0, 1, 1, 1 },
-			{ 0, 0, 0, 0 },
-			{ 0, 0, 0, 0 }
-		},
-		{
-			{ 0, 0, 1, 0 },
-			{ 0, 0, 1, 1 },
-			{ 0, 0, 1, 0 },
-			{ 0, 0, 0, 0 }
-		},
-		{
-			{ 0, 0, 0, 0 },
-			{ 0, 1, 1, 1 },
-			{ 0, 0, 1, 0 },
-			{ 0, 0, 0, 0 },
-		},
-		{
-			{ 0, 0, 1, 0 },
-			{ 0, 1, 1, 0 },
-			{ 0, 0, 1, 0 },
-			{ 0, 0, 0, 0 }
-		}
-	},
-	// }}}
-
-	// {{{ Extended.
-	{
-		{
-			{ 0, 0, 0, 1 },
-			{ 0, 1, 1, 1 },
-			{ 0, 1, 0, 0 },
-			{ 0, 0, 0, 0 },
-		},
-		{
-			{ 0, 1, 1, 0 },
-			{ 0, 0, 1, 0 },
-			{ 0, 0, 1, 1 },
-			{ 0, 0, 0, 0 }
-		},
-		{
-			{ 0, 0, 0, 1 },
-			{ 0, 1, 1, 1 },
-			{ 0, 1, 0, 0 },
-			{ 0, 0, 0, 0 },
-		},
-		{
-			{ 0, 1, 1, 0 },
-			{ 0, 0, 1, 0 },
-			{ 0, 0, 1, 1 },
-			{ 0, 0, 0, 0 }
-		}
-	},
-
-	{
-		{
-			{ 0, 1, 1, 0 },
-			{ 0, 0, 1, 1 },
-			{ 0, 0, 0, 1 },
-			{ 0, 0, 0, 0 }
-		},
-		{
-			{ 0, 0, 0, 1 },
-			{ 0, 0, 1, 1 },
-			{ 0, 1, 1, 0 },
-			{ 0, 0, 0, 0 }
-		},
-		{
-			{ 0, 1, 0, 0 },
-			{ 0, 1, 1, 0 },
-			{ 0, 0, 1, 1 },
-			{ 0, 0, 0, 0 }
-		},
-		{
-			{ 0, 0, 1, 1 },
-			{ 0, 1, 1, 0 },
-			{ 0, 1, 0, 0 },
-			{ 0, 0, 0, 0 }
-		}
-	},
-
-	{
-		{
-			{ 0, 1, 1, 1 },
-			{ 1, 1, 1, 0 },
-			{ 0, 0, 0, 0 },
-			{ 0, 0, 0, 0 }
-		},
-		{
-			{ 0, 1, 0, 0 },
-			{ 0, 1, 1, 0 },
-			{ 0, 1, 1, 0 },
-			{ 0, 0, 1, 0 }
-		},
-		{
-			{ 0, 1, 1, 1 },
-			{ 1, 1, 1, 0 },
-			{ 0, 0, 0, 0 },
-			{ 0, 0, 0, 0 }
-		},
-		{
-			{ 0, 1, 0, 0 },
-			{ 0, 1, 1, 0 },
-			{ 0, 1, 1, 0 },
-			{ 0, 0, 1, 0 }
-		},
-	},
-	// }}}
-
-	// {{{ Nightmare
-	{
-		{
-			{ 0, 0, 1, 0 },
-			{ 0, 1, 1, 1 },
-			{ 0, 0, 1, 0 },
-			{ 0, 0, 0, 0 },
-		},
-		{
-			{ 0, 0, 1, 0 },
-			{ 0, 1, 1, 1 },
-			{ 0, 0, 1, 0 },
-			{ 0, 0, 0, 0 },
-		},
-		{
-			{ 0, 0, 1, 0 },
-			{ 0, 1, 1, 1 },
-			{ 0, 0, 1, 0 },
-			{ 0, 0, 0, 0 },
-		},
-		{
-			{ 0, 0, 1, 0 },
-			{ 0, 1, 1, 1 },
-			{ 0, 0, 1, 0 },
-			{ 0, 0, 0, 0 },
-		},
-	},
-
-	{
-		{
-			{ 0, 1, 1, 1 },
-			{ 0, 1, 0, 1 },
-			{ 0, 1, 1, 1 },
-			{ 0, 0, 0, 0 },
-		},
-		{
-			{ 0, 1, 1, 1 },
-			{ 0, 1, 0, 1 },
-			{ 0, 1, 1, 1 },
-			{ 0, 0, 0, 0 },
-		},
-		{
-			{ 0, 1, 1, 1 },
-			{ 0, 1, 0, 1 },
-			{ 0, 1, 1, 1 },
-			{ 0, 0, 0, 0 },
-		},
-		{
-			{ 0, 1, 1, 1 },
-			{ 0, 1, 0, 1 },
-			{ 0, 1, 1, 1 },
-			{ 0, 0, 0, 0 },
-		},
-	},
-	// }}}
-};
+static_assert(LEN(shape_infos) == SHAPE_RAND_MAX);
 
 unsigned int
 shape_max_rows(const struct shape *shape)
 {
 	assert(shape);
 
-	unsigned int rows = 0;
-
-	for (int r = 0; r < 4; ++r) {
-		for (int c = 0; c < 4; ++c) {
-			if (shape->def[0][r][c]) {
-				rows++;
-				break;
-			}
-		}
-	}
-
-	return rows;
+	return shape_infos[shape->k][0].h;
 }
 
 unsigned int
@@ -382,18 +40,7 @@ shape_max_columns(const struct shape *shape)
 {
 	assert(shape);
 
-	unsigned int columns = 0;
-
-	for (int c = 0; c < 4; ++c) {
-		for (int r = 0; r < 4; ++r) {
-			if (shape->def[0][r][c]) {
-				columns++;
-				break;
-			}
-		}
-	}
-
-	return columns;
+	return shape_infos[shape->k][0].w;
 }
 
 unsigned int
@@ -401,19 +48,7 @@ shape_gap_rows(const struct shape *shape)
 {
 	assert(shape);
 
-	unsigned int blanks = 0;
-
-	for (int r = 0; r < 4; ++r) {
-		for (int c = 0; c < 4; ++c) {
-			if (shape->def[0][r][c])
-				goto exit;
-		}
-
-		blanks++;
-	}
-
-exit:
-	return blanks;
+	return shape_infos[shape->k][0].y;
 }
 
 unsigned int
@@ -421,57 +56,7 @@ shape_gap_columns(const struct shape *shape)
 {
 	assert(shape);
 
-	unsigned int blanks = 0;
-
-	for (int c = 0; c < 4; ++c) {
-		for (int r = 0; r < 4; ++r) {
-			if (shape->def[0][r][c])
-				goto exit;
-		}
-
-		blanks++;
-	}
-
-exit:
-	return blanks;
-}
-
-void
-shape_shuffle(struct shape *bag, size_t bagsz, enum shape_rand r)
-{
-	assert(bagsz >= r);
-
-	size_t i, j;
-	struct shape tmp;
-
-	memset(bag, 0, sizeof (*bag) * bagsz);
-
-	// First, we create an ordered sequence of every standard pieces in the
-	// bag.
-	for (i = 0; i < SHAPE_RAND_STANDARD; ++i) {
-		memcpy(bag[i].def, shapes[i], sizeof (shapes[i]));
-		bag[i].k = i;
-	}
-
-	// Shuffle the initial sequence.
-	for (size_t p = 0; p < SHAPE_RAND_STANDARD - p; p++) {
-		j = p + rand() / (RAND_MAX / (SHAPE_RAND_STANDARD - p) + 1);
-		tmp = bag[j];
-		bag[j] = bag[p];
-		bag[p] = tmp;
-	}
-
-	// Now if the bag is bigger, add some random shapes as well. If we're
-	// being asked to put some !standard pieces, do it less often because
-	// they are very hard to positionate.
-	for (; i < bagsz; ++i) {
-		if (nrand(0, 3) == 0)
-			bag[i].k = nrand(0, r - 1);
-		else
-			bag[i].k = nrand(0, SHAPE_RAND_STANDARD);
-
-		memcpy(bag[i].def, shapes[bag[i].k], sizeof (bag[i].def));
-	}
+	return shape_infos[shape->k][0].x;
 }
 
 void
@@ -20,6 +20,7 @@
 #define STRIS_SHAPE_H
 
 #include <stddef.h>
+#include <stdint.h>
 
 enum shape_rand {
 	SHAPE_RAND_STANDARD = 7,
@@ -28,14 +29,51 @@ enum shape_rand {
 	SHAPE_RAND_MAX = SHAPE_RAND_NIGHTMARE
 };
 
+/**
+ * \struct shape
+ * \brief Shape in play.
+ *
+ * The geometry is not stored in the shape itself but looked up in a static
+ * table from its kind and orientation, see ::shape_info.
+ */
 struct shape {
-	int k;
-	int x;
-	int y;
-	int o;
-	int def[4][4][4];
+	int k;                  /*!< kind index */
+	int x;                  /*!< column in board */
+	int y;                  /*!< row in board */
+	int o;                  /*!< orientation (0..3) */
 };
 
+/**
+ * \struct shape_info
+ * \brief Precomputed shape geometry for a given orientation.
+ *
+ * Cells are laid out in a 4x4 grid, the table is generated at build time by
+ * shape-gen.
+ */
+struct shape_info {
+	uint16_t cells;         /*!< cells mask, bit r * 4 + c for row r column c */
+	uint8_t rows[4];        /*!< column mask of every row, bit c for column c */
+	uint8_t bottom[4];      /*!< lowest used row + 1 of every column, 0 if none */
+	uint8_t x;              /*!< first used column */
+	uint8_t y;              /*!< first used row */
+	uint8_t w;              /*!< number of columns used */
+	uint8_t h;              /*!< number of rows used */
+};
+
+/**
+ * Geometry of every shape kind in every orientation.
+ */
+extern const struct shape_info shape_infos[SHAPE_RAND_MAX][4];
+
+/**
+ * Returns the precomputed geometry of the shape at its current orientation.
+ */
+static inline const struct shape_info *
+shape_info(const struct shape *shape)
+{
+	return &shape_infos[shape->k][shape->o];
+}
+
 /**
  * Returns the maximum number of rows that this shape consists of.
  *
@@ -52,8 +90,21 @@ shape_max_rows(const struct shape *shape);
 unsigned int
 shape_max_columns(const struct shape *shape);
 
-void
-shape_shuffle(struct shape *, size_t, enum shape_rand);
+/**
+ * Returns the number of empty rows above the shape.
+ *
+ * This function only applies on the original first rotation.
+ */
+unsigned int
+shape_gap_rows(const struct shape *shape);
+
+/**
+ * Returns the number of empty columns on the left of the shape.
+ *
+ * This function only applies on the original first rotation.
+ */
+unsigned int
+shape_gap_columns(const struct shape *shape);
 
 void
 shape_rotate(struct shape *, int);
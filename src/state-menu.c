@@ -72,7 +72,7 @@ struct menu {
 static void
 menu_entry(struct coroutine *self)
 {
-	struct texture texture;
+	struct texture texture = {};
 	struct menu *menu;
 
 	menu = MENU(self, coroutine);
@@ -132,5 +132,6 @@ menu_run(void)
 	menu = alloc(1, sizeof (*menu));
 	menu->coroutine.entry = menu_entry;
 	menu->coroutine.terminate = menu_terminate;
+	menu->coroutine.prio = COROUTINE_PRIO_LOGIC;
 	coroutine_init(&menu->coroutine);
 }
@@ -73,5 +73,6 @@ mode_run(void)
 	state = alloc(1, sizeof (*state));
 	state->coroutine.entry = mode_entry;
 	state->coroutine.terminate = mode_terminate;
+	state->coroutine.prio = COROUTINE_PRIO_LOGIC;
 	coroutine_init(&state->coroutine);
 }
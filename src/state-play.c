@@ -19,12 +19,15 @@
 #include <assert.h>
 #include <math.h>
 #include <stdio.h>
+#include <stdlib.h>
 
 #include <SDL3/SDL.h>
 
 #include "board.h"
 #include "coroutine.h"
+#include "game.h"
 #include "node.h"
+#include "rng.h"
 #include "score.h"
 #include "shape.h"
 #include "sound.h"
@@ -50,20 +53,31 @@
 #define SCENE(Ptr, Field) \
         (CONTAINER_OF(Ptr, struct scene, Field))
 
-#define PLAY_INIT_SHAPE(Scene, Index, Image)                                    \
+#define PLAY_LOAD_BLOCK(Blocks, Index, Image)                                   \
 do {                                                                            \
-        texture_load(&(Scene)->shapes[(Index)], (Image), sizeof ((Image)));     \
+        texture_load(&(Blocks)[(Index)], (Image), sizeof ((Image)));            \
 } while (0)
 
-enum fallrate {
-	FALLRATE_INIT = 900,
-	FALLRATE_DECR = 74
-};
+/*
+ * Transparency of the landing preview.
+ */
+#define GHOST_ALPHA 70
+
+/*
+ * Number of incoming shapes generated ahead.
+ */
+#define LOOKAHEAD 5
+
+/*
+ * Time in milliseconds the game is advanced by at once, the real time
+ * elapsed is consumed by as many ticks as needed up to every input event and
+ * then up to the frame.
+ */
+#define TICK 1
 
 enum state {
 	RUNNING,
 	PAUSED,
-	ANIMATING,
 	DEAD,
 	TERMINATED
 };
@@ -77,38 +91,47 @@ struct scene {
 	enum state state;
 	enum mode mode;
 
-	/* current stats */
-	unsigned int level;
-	unsigned int lines;
-
 	/* top level stats */
 	struct label lbl_level;
 	struct label lbl_lines;
 
+	/* screen area reserved for the board, border included */
+	int view_x;
+	int view_y;
+	unsigned int view_w;
+	unsigned int view_h;
+
+	/* size of a board cell on screen */
+	unsigned int cell_w;
+	unsigned int cell_h;
+
 	/* game board background */
 	struct node bg;
 
-	/* game board foreground */
+	/* game board foreground, only the shapes locked so far */
 	struct node fg;
 
+	/* current shape and where it lands, sprites moved over the board */
+	struct node ghost;
+	struct node piece;
+
 	/* next shape texture. */
 	struct node next;
 
-	/* game board and current shape moving */
-	Board board;
-	struct shape shape;
+	/* game rules, board and current shape moving */
+	struct game game;
 
-	/*
-	 * Bag of shapes that are incoming.
-	 *
-	 * They are not generated equal but on a more useful list to avoid
-	 * getting too many consecutive annoying shapes.
-	 *
-	 * See https://tetris.fandom.com/wiki/Random_Generator
-	 */
-	struct shape shape_bag[SHAPE_RAND_NIGHTMARE];
-	enum shape_rand shape_bag_rand;
-	size_t shape_bag_iter;
+	/* SDL time in nanoseconds the game was advanced to */
+	uint64_t time;
+
+	/* time not consumed by the game yet in nanoseconds */
+	uint64_t lag;
+
+	/* game inputs currently held */
+	enum game_input held;
+
+	/* step of the line blinking last drawn */
+	size_t blink;
 
 	/* pause overall overlay */
 	struct node pause;
@@ -119,22 +142,44 @@ struct scene {
 	/* input handler coroutine */
 	struct coroutine input;
 
-	/* loaded texture for every shape */
-	struct texture shapes[SHAPE_RAND_MAX];
+	/* block of every shape side by side and the size of one */
+	struct texture blocks;
+	unsigned int block_w;
+	unsigned int block_h;
+
+	/* cells drawn at once, the whole board and a shape */
+	struct texture_quad *quads;
 };
 
 static void
 play_init_bg(struct scene *scene)
 {
+	const struct board *board = &scene->game.board;
 	struct texture texture;
 	unsigned int w, h;
+	double scale;
+
+	/*
+	 * The screen area reserved for the board is the one of a default
+	 * board, larger boards get smaller cells to fit in.
+	 */
+	scene->view_w = (scene->block_w * BOARD_W) + 2;
+	scene->view_h = (scene->block_h * BOARD_H) + 2;
+	scene->view_x = (UI_W - scene->view_w) / 2;
+	scene->view_y = (UI_H - scene->view_h) - scene->view_x;
+
+	scale = fmin(1.0, fmin(
+	    (double)(scene->view_w - 2) / (scene->block_w * board->w),
+	    (double)(scene->view_h - 2) / (scene->block_h * board->h)));
+	scene->cell_w = fmax(1.0, scene->block_w * scale);
+	scene->cell_h = fmax(1.0, scene->block_h * scale);
 
 	/*
 	 * Background dimensions is number of blocks + 2 pixels in each
 	 * direction to add a small border.
 	 */
-	w = (scene->shapes->w * BOARD_W) + 2;
-	h = (scene->shapes->h * BOARD_H) + 2;
+	w = (scene->cell_w * board->w) + 2;
+	h = (scene->cell_h * board->h) + 2;
 
 	texture_init(&texture,  w, h);
 
@@ -150,8 +195,9 @@ play_init_bg(struct scene *scene)
 	ui_draw_line(UI_PALETTE_BORDER, 0, 0, 0, h);
 	ui_draw_line(UI_PALETTE_BORDER, w - 1, 0, w - 1, h);
 
-	scene->bg.x = (UI_W - texture.w) / 2;
-	scene->bg.y = (UI_H - texture.h) - scene->bg.x;
+	/* Horizontally centered and bottom aligned in the view. */
+	scene->bg.x = scene->view_x + (int)(scene->view_w - texture.w) / 2;
+	scene->bg.y = scene->view_y + (int)(scene->view_h - texture.h);
 	node_wrap(&scene->bg, &texture);
 	UI_END();
 }
@@ -174,15 +220,44 @@ play_init_fg(struct scene *scene)
 static void
 play_update_stat(struct scene *scene)
 {
-	ui_printf_shadowed(&scene->lbl_level.texture, UI_FONT_STATS, UI_PALETTE_FG, "level %u", scene->level);
-	ui_printf_shadowed(&scene->lbl_lines.texture, UI_FONT_STATS, UI_PALETTE_FG, "lines %u", scene->lines);
+	ui_printf_shadowed(&scene->lbl_level.texture, UI_FONT_STATS, UI_PALETTE_FG, "level %u", scene->game.level);
+	ui_printf_shadowed(&scene->lbl_lines.texture, UI_FONT_STATS, UI_PALETTE_FG, "lines %u", scene->game.lines);
+}
+
+/*
+ * Fill a quad drawing the block of the kind k scaled to w:h at x;y.
+ */
+static inline void
+play_quad(const struct scene *scene,
+          struct texture_quad *quad,
+          int k,
+          int x,
+          int y,
+          unsigned int w,
+          unsigned int h,
+          unsigned int alpha)
+{
+	*quad = (struct texture_quad) {
+		.sx = k * scene->block_w,
+		.sw = scene->block_w,
+		.sh = scene->block_h,
+		.x = x,
+		.y = y,
+		.w = w,
+		.h = h,
+		.alpha = alpha
+	};
 }
 
 static void
 play_update_next_shape(struct scene *scene)
 {
-	const struct shape *next = &scene->shape_bag[scene->shape_bag_iter];
+	const struct shape *next = &(const struct shape) {
+		.k = queue_peek(&scene->game.queue, 0)
+	};
+	const struct shape_info *info = &shape_infos[next->k][0];
 	unsigned int rows, columns, w, h;
+	size_t quadsz = 0;
 	int x, y;
 
 	/*
@@ -196,8 +271,8 @@ play_update_next_shape(struct scene *scene)
 	assert(columns);
 
 	/* Adjust to texture size. */
-	w = columns * (scene->shapes->w / 2);
-	h = rows * (scene->shapes->h / 2);
+	w = columns * (scene->block_w / 2);
+	h = rows * (scene->block_h / 2);
 
 	/* Render the shape on the texture with half width/height. */
 	UI_BEGIN(scene->next.texture);
@@ -209,26 +284,108 @@ play_update_next_shape(struct scene *scene)
 		x = (scene->next.texture->w) - (w);
 
 		if (columns != 4)
-			x -= scene->shapes->w / 2;
+			x -= scene->block_w / 2;
 
 		for (int c = 0; c < 4; ++c) {
-			if (next->def[0][r][c])
-				texture_scale(&scene->shapes[next->k],
+			if (info->cells >> (r * 4 + c) & 1)
+				play_quad(scene, &scene->quads[quadsz++], next->k,
 				    x, y,
-				    scene->shapes->w / 2,
-				    scene->shapes->h / 2);
+				    scene->block_w / 2,
+				    scene->block_h / 2, 255);
 
-			x += scene->shapes->w / 2;
+			x += scene->block_w / 2;
 		}
 
-		y += scene->shapes->h / 2;
+		y += scene->block_h / 2;
 	}
 
+	texture_batch(&scene->blocks, scene->quads, quadsz);
 	UI_END();
 }
 
+/*
+ * Fill the quads of the current shape with its 4x4 grid origin at the given
+ * pixel position and return how many were added.
+ */
+static size_t
+play_update_shape(struct scene *scene, struct texture_quad *quads, int x, int y)
+{
+	const struct game *game = &scene->game;
+	const struct shape_info *info = shape_info(&game->shape);
+	size_t quadsz = 0;
+
+	for (int r = info->y; r < info->y + info->h; ++r)
+		for (int c = info->x; c < info->x + info->w; ++c)
+			if (info->rows[r] >> c & 1)
+				play_quad(scene, &quads[quadsz++], game->shape.k,
+				    x + c * scene->cell_w,
+				    y + r * scene->cell_h,
+				    scene->cell_w, scene->cell_h, 255);
+
+	return quadsz;
+}
+
+/*
+ * The shape is not part of the board until it locks, it has its own texture
+ * and so does its ghost, both redrawn only when it rotates or a new one
+ * spawns. Moving and falling only move the nodes.
+ */
 static void
-play_update_board(struct scene *scene, unsigned int mask, unsigned int alpha)
+play_update_piece(struct scene *scene)
+{
+	size_t quadsz;
+
+	quadsz = play_update_shape(scene, scene->quads, 0, 0);
+
+	UI_BEGIN(scene->piece.texture);
+	ui_clear(0x00000000);
+	texture_batch(&scene->blocks, scene->quads, quadsz);
+	UI_END();
+
+	UI_BEGIN(scene->ghost.texture);
+	ui_clear(0x00000000);
+	texture_batch(&scene->blocks, scene->quads, quadsz);
+	UI_END();
+}
+
+/*
+ * Place the shape node where it is on screen right now. The game only knows
+ * whole rows so the progress toward the next one (including the time not
+ * simulated yet) is added to slide smoothly at any refresh rate.
+ */
+static void
+play_move_piece(struct scene *scene)
+{
+	const struct game *game = &scene->game;
+	double off = 0.0;
+
+	if (game->state != GAME_STATE_FALLING) {
+		scene->piece.hide = scene->ghost.hide = 1;
+		return;
+	}
+
+	/* Both are 32.32 fixed point numbers. */
+	if (game->shape.y < game->ghost) {
+		off = ldexp(game->fall, -32) +
+		    ldexp(game->gravity, -32) * scene->lag / SDL_NS_PER_MS;
+		off = fmin(off, game->ghost - game->shape.y);
+	}
+
+	scene->piece.hide = 0;
+	scene->piece.x = scene->fg.x + game->shape.x * (int)scene->cell_w;
+	scene->piece.y = scene->fg.y + (game->shape.y + off) * scene->cell_h;
+
+	scene->ghost.hide = 0;
+	scene->ghost.x = scene->piece.x;
+	scene->ghost.y = scene->fg.y + game->ghost * (int)scene->cell_h;
+}
+
+/*
+ * Redraw the shapes locked so far, this is only needed when the board
+ * changes or while lines are being cleared.
+ */
+static void
+play_update_board(struct scene *scene, uint64_t mask, unsigned int alpha)
 {
 	static const uint32_t ramp[] = {
 		0x33984bff,
@@ -244,31 +401,28 @@ play_update_board(struct scene *scene, unsigned int mask, unsigned int alpha)
 		0x1a1932ff
 	};
 
-	int level, s;
-
-	UI_BEGIN(scene->fg.texture);
-	ui_clear(0x00000000);
+	const struct board *board = &scene->game.board;
+	size_t quadsz = 0;
+	int s;
 
-	for (int r = 0; r < BOARD_H; ++r) {
-		for (int c = 0; c < BOARD_W; ++c) {
-			if (!(s = scene->board[r][c]))
-				continue;
+	/* Cap to level 11. */
+	ui_background_set(ramp[(int)fmin(scene->game.level, 11) - 1]);
 
-			if (mask >> r & 0x1)
-				texture_alpha(&scene->shapes[s - 1], alpha);
-			else
-				texture_alpha(&scene->shapes[s - 1], 255);
-
-			/* Cap to level 11. */
-			level = fmin(scene->level, 11);
-
-			ui_background_set(ramp[level - 1]);
-			texture_render(&scene->shapes[s - 1],
-			    (c * scene->shapes[1].w),
-			    (r * scene->shapes[1].h));
-		}
-	}
+	/*
+	 * Every cell goes in a single batch, the cells being cleared are only
+	 * drawn with a different vertex transparency.
+	 */
+	for (int r = 0; r < board->h; ++r)
+		for (int c = 0; c < board->w; ++c)
+			if ((s = board->cells[r][c]))
+				play_quad(scene, &scene->quads[quadsz++], s - 1,
+				    c * scene->cell_w, r * scene->cell_h,
+				    scene->cell_w, scene->cell_h,
+				    mask >> r & 0x1 ? alpha : 255);
 
+	UI_BEGIN(scene->fg.texture);
+	ui_clear(0x00000000);
+	texture_batch(&scene->blocks, scene->quads, quadsz);
 	UI_END();
 }
 
@@ -287,16 +441,16 @@ play_init_stat(struct scene *scene)
 	 * This is the remaining space between the top of the window and the
 	 * beginning of the game view.
 	 */
-	vheight = scene->bg.y;
+	vheight = scene->view_y;
 
 	/* level <n> */
-	scene->lbl_level.node.x = scene->bg.x;
+	scene->lbl_level.node.x = scene->view_x;
 	scene->lbl_level.node.y = vheight / 4 - scene->lbl_level.texture.h / 2;
 	scene->lbl_level.node.texture = &scene->lbl_level.texture;
 	node_init(&scene->lbl_level.node);
 
 	/* lines <n> */
-	scene->lbl_lines.node.x = scene->bg.x;
+	scene->lbl_lines.node.x = scene->view_x;
 	scene->lbl_lines.node.y = vheight - (vheight / 3) - (scene->lbl_lines.texture.h / 2);
 	scene->lbl_lines.node.texture = &scene->lbl_lines.texture;
 	node_init(&scene->lbl_lines.node);
@@ -312,34 +466,68 @@ play_init_next(struct scene *scene)
 {
 	struct texture texture;
 
-	texture_init(&texture, scene->bg.y, scene->bg.y);
-	scene->next.x = scene->bg.x + scene->bg.texture->w - scene->bg.y;
+	texture_init(&texture, scene->view_y, scene->view_y);
+	scene->next.x = scene->view_x + scene->view_w - scene->view_y;
 	node_wrap(&scene->next, &texture);
 
 	play_update_next_shape(scene);
 }
 
 static void
-play_init_shapes(struct scene *scene)
+play_init_piece(struct scene *scene)
+{
+	struct texture texture;
+
+	/* The ghost goes first to stay below the shape. */
+	texture_init(&texture, scene->cell_w * 4, scene->cell_h * 4);
+	texture_alpha(&texture, GHOST_ALPHA);
+	node_wrap(&scene->ghost, &texture);
+
+	texture_init(&texture, scene->cell_w * 4, scene->cell_h * 4);
+	node_wrap(&scene->piece, &texture);
+
+	play_update_piece(scene);
+	play_move_piece(scene);
+}
+
+/*
+ * Blocks are packed in a single texture so that the whole board is drawn in
+ * one batch, the block of the shape kind k starts at column k * block_w.
+ */
+static void
+play_init_blocks(struct scene *scene)
 {
-	PLAY_INIT_SHAPE(scene,  0, assets_img_block5);
-	PLAY_INIT_SHAPE(scene,  1, assets_img_block6);
-	PLAY_INIT_SHAPE(scene,  2, assets_img_block2);
-	PLAY_INIT_SHAPE(scene,  3, assets_img_block4);
-	PLAY_INIT_SHAPE(scene,  4, assets_img_block1);
-	PLAY_INIT_SHAPE(scene,  5, assets_img_block8);
-	PLAY_INIT_SHAPE(scene,  6, assets_img_block3);
-	PLAY_INIT_SHAPE(scene,  7, assets_img_block9);
-	PLAY_INIT_SHAPE(scene,  8, assets_img_block10);
-	PLAY_INIT_SHAPE(scene,  9, assets_img_block11);
-	PLAY_INIT_SHAPE(scene, 10, assets_img_block12);
-	PLAY_INIT_SHAPE(scene, 11, assets_img_block7);
+	struct texture blocks[SHAPE_RAND_MAX];
+
+	PLAY_LOAD_BLOCK(blocks,  0, assets_img_block5);
+	PLAY_LOAD_BLOCK(blocks,  1, assets_img_block6);
+	PLAY_LOAD_BLOCK(blocks,  2, assets_img_block2);
+	PLAY_LOAD_BLOCK(blocks,  3, assets_img_block4);
+	PLAY_LOAD_BLOCK(blocks,  4, assets_img_block1);
+	PLAY_LOAD_BLOCK(blocks,  5, assets_img_block8);
+	PLAY_LOAD_BLOCK(blocks,  6, assets_img_block3);
+	PLAY_LOAD_BLOCK(blocks,  7, assets_img_block9);
+	PLAY_LOAD_BLOCK(blocks,  8, assets_img_block10);
+	PLAY_LOAD_BLOCK(blocks,  9, assets_img_block11);
+	PLAY_LOAD_BLOCK(blocks, 10, assets_img_block12);
+	PLAY_LOAD_BLOCK(blocks, 11, assets_img_block7);
+
+	scene->block_w = blocks[0].w;
+	scene->block_h = blocks[0].h;
+	texture_atlas(&scene->blocks, blocks, LEN(blocks));
+
+	for (size_t i = 0; i < LEN(blocks); ++i)
+		texture_finish(&blocks[i]);
+
+	/* A shape has at most 16 cells in its 4x4 grid. */
+	scene->quads = alloc(scene->game.board.w * scene->game.board.h + 16,
+	    sizeof (*scene->quads));
 }
 
 static void
 play_init_pause(struct scene *scene)
 {
-	struct texture texture, text;
+	struct texture texture, text = {};
 
 	ui_printf(&text, UI_FONT_MENU, UI_PALETTE_FG, "pause");
 
@@ -354,131 +542,190 @@ play_init_pause(struct scene *scene)
 	node_wrap(&scene->pause, &texture);
 }
 
-static int
-play_can_move(struct scene *scene, int dx, int dy)
+/*
+ * Convert keys into game inputs.
+ */
+static enum game_input
+play_inputs(enum key keys)
 {
-	struct shape shape = scene->shape;
+	enum game_input inputs = GAME_INPUT_NONE;
 
-	/* Try to put in the new place. */
-	shape.x += dx;
-	shape.y += dy;
+	if (keys & KEY_LEFT)
+		inputs |= GAME_INPUT_LEFT;
+	if (keys & KEY_RIGHT)
+		inputs |= GAME_INPUT_RIGHT;
+	if (keys & KEY_DOWN)
+		inputs |= GAME_INPUT_DOWN;
+	if (keys & KEY_UP)
+		inputs |= GAME_INPUT_ROTATE;
+	if (keys & KEY_DROP)
+		inputs |= GAME_INPUT_DROP;
 
-	return board_check(scene->board, &shape);
+	return inputs;
 }
 
+/*
+ * Redraw what the game events changed, full lines blink during the whole
+ * clear delay.
+ */
 static void
-play_move(struct scene *scene, enum key keys)
+play_update(struct scene *scene, enum game_event ev)
 {
-	int dx = 0, dy = 0, moved;
-
-	if (keys & KEY_LEFT)
-		dx = -1;
-	else if (keys & KEY_RIGHT)
-		dx = +1;
+	static const unsigned int alpharamp[] = {
+		255, 230, 205, 180, 155, 130, 105,  80,
+		 55,  30,   5,  30,  55,  80, 105, 130,
+		155, 180, 205, 230, 255, 205, 155, 105,
+		 55,   5,  55, 105, 155, 205, 255,   0,
+		255,   0, 255,   0, 255,   0,   0, 255
+	};
 
-	if (keys & KEY_DOWN)
-		dy += 1;
+	const struct game *game = &scene->game;
+	size_t i;
 
-	if (dx || dy) {
-		board_unset(scene->board, &scene->shape);
+	if (ev & GAME_EVENT_ROTATE)
+		sound_play(SOUND_MOVE);
+	if (ev & GAME_EVENT_DROP)
+		sound_play(SOUND_DROP);
+	if (ev & GAME_EVENT_CLEAR) {
+		play_update_stat(scene);
+		sound_play(SOUND_CLEAN);
+	}
+	if (ev & GAME_EVENT_SPAWN)
+		play_update_next_shape(scene);
+	if (ev & (GAME_EVENT_ROTATE | GAME_EVENT_SPAWN))
+		play_update_piece(scene);
 
-		if ((moved = play_can_move(scene, dx, dy))) {
-			scene->shape.x += dx;
-			scene->shape.y += dy;
-		}
+	if (game->state == GAME_STATE_CLEARING) {
+		i = (size_t)game->timer * LEN(alpharamp) / game->clear_delay;
 
-		board_set(scene->board, &scene->shape);
+		if (i >= LEN(alpharamp))
+			i = LEN(alpharamp) - 1;
 
-		/*
-		 * Redraw board immediately. If the direction is going bottom,
-		 * we rearm the fall rate delay to avoid spawning after the
-		 * initial wait time already passed.
-		 */
+		/* The stack only changes when the blinking does. */
+		if ((ev & GAME_EVENT_CLEAR) || i != scene->blink) {
+			scene->blink = i;
+			play_update_board(scene, game->clearing, alpharamp[i]);
+		}
+	} else if (ev & (GAME_EVENT_LOCK | GAME_EVENT_SPAWN))
 		play_update_board(scene, 0, 0);
 
-		if (dy && moved)
-			coroutine_rearm(&scene->logic);
-	}
+	play_move_piece(scene);
 }
 
+/*
+ * Animate a line per line full board from bottom to top gradually. The game
+ * is over so its board is not used anymore.
+ */
 static void
-play_rotate(struct scene *scene, enum key keys)
+play_dead(struct scene *scene)
 {
-	int o;
+	scene->state = DEAD;
 
-	if (!(keys & KEY_UP))
-		return;
+	for (int r = scene->game.board.h - 1; r >= 0; --r) {
+		sound_play(SOUND_TICK);
 
-	o = scene->shape.o;
+		for (int c = 0; c < scene->game.board.w; ++c)
+			board_put(&scene->game.board, c, r, 11);
 
-	/* As usual, unset before trying. */
-	board_unset(scene->board, &scene->shape);
-	shape_rotate(&scene->shape, 1);
+		play_update_board(scene, 0, 0);
+		coroutine_sleep(40);
+	}
 
-	/* Cancel orientation. */
-	if (!board_check(scene->board, &scene->shape))
-		scene->shape.o = o;
-	else
-		sound_play(SOUND_MOVE);
+	coroutine_sleep(500);
+}
 
-	board_set(scene->board, &scene->shape);
-	play_update_board(scene, 0, 0);
+/*
+ * Advance the game up to the given SDL time.
+ */
+static enum game_event
+play_advance(struct scene *scene, uint64_t time)
+{
+	enum game_event ev = GAME_EVENT_NONE;
+
+	if (time <= scene->time)
+		return ev;
+	if (time - scene->time > FRAME_MAX)
+		scene->time = time - FRAME_MAX;
+
+	scene->lag += time - scene->time;
+	scene->time = time;
+
+	while (scene->lag >= SDL_MS_TO_NS(TICK) && !(ev & GAME_EVENT_OVER)) {
+		scene->lag -= SDL_MS_TO_NS(TICK);
+		ev |= game_step(&scene->game, scene->held, TICK);
+	}
+
+	return ev;
 }
 
+/*
+ * Apply a key press or release at the time it happened, the game is first
+ * advanced up to it.
+ */
 static void
-play_drop(struct scene *scene, enum key keys)
+play_input(struct scene *scene, const struct input *in)
 {
-	if (!(keys & KEY_DROP))
-		return;
-
-	board_unset(scene->board, &scene->shape);
+	enum game_event ev;
 
-	while (play_can_move(scene, 0, 1))
-		scene->shape.y += 1;
+	ev = play_advance(scene, in->time);
 
-	board_set(scene->board, &scene->shape);
-	sound_play(SOUND_DROP);
+	if (in->down)
+		scene->held |= play_inputs(in->key);
+	else
+		scene->held &= ~play_inputs(in->key);
 
-	/* Make sure the game will spawn a piece immediately. */
-	coroutine_cancel(&scene->logic);
+	ev |= game_step(&scene->game, scene->held, 0);
+	play_update(scene, ev);
 }
 
+/*
+ * Input events are read in order and applied at their own time. This
+ * coroutine has the input priority so that events of a frame are applied
+ * before the logic one advances the game up to the frame.
+ */
 static void
 play_input_entry(struct coroutine *self)
 {
 	struct scene *scene;
-	enum key keys;
+	struct input in;
 
 	scene = SCENE(self, input);
 
 	while (scene->state != TERMINATED) {
-		keys = stris_pressed();
+		while (!stris_poll(&in))
+			coroutine_wait_input();
 
 		switch (scene->state) {
 		case RUNNING:
-			if (keys & KEY_CANCEL) {
+			/* Logic will notice on its next run. */
+			if (scene->game.state == GAME_STATE_OVER)
+				break;
+
+			if (in.down && in.key == KEY_CANCEL) {
+				play_update(scene, play_advance(scene, in.time));
 				scene->state = PAUSED;
 				scene->pause.hide = 0;
-				scene->logic.pause = 1;
-			} else {
-				play_move(scene, keys);
-				play_rotate(scene, keys);
-				play_drop(scene, keys);
-			}
+				coroutine_pause(&scene->logic, 1);
+			} else
+				play_input(scene, &in);
 			break;
 		case PAUSED:
-			if (keys & KEY_CANCEL) {
+			/* Keys pressed meanwhile are ignored but not released ones. */
+			if (!in.down)
+				scene->held &= ~play_inputs(in.key);
+			else if (in.key == KEY_CANCEL) {
 				scene->state = TERMINATED;
-				scene->logic.pause = 0;
+				coroutine_pause(&scene->logic, 0);
 				coroutine_cancel(&scene->logic);
-			} else if (keys & KEY_SELECT) {
+			} else if (in.key == KEY_SELECT) {
 				scene->state = RUNNING;
+				scene->time = in.time;
 				scene->pause.hide = 1;
-				scene->logic.pause = 0;
+				coroutine_pause(&scene->logic, 0);
 			}
 			break;
 		case DEAD:
-			if (keys & (KEY_CANCEL | KEY_SELECT))
+			if (in.down && in.key & (KEY_CANCEL | KEY_SELECT))
 				scene->state = TERMINATED;
 			break;
 		default:
@@ -487,172 +734,27 @@ play_input_entry(struct coroutine *self)
 	}
 }
 
-static void
-play_shuffle(struct scene *scene)
-{
-	scene->shape_bag_iter = 0;
-	shape_shuffle(scene->shape_bag, LEN(scene->shape_bag), scene->shape_bag_rand);
-}
-
-static void
-play_spawn(struct scene *scene)
-{
-	/* Move next shape to current and create a new one. */
-	scene->shape = scene->shape_bag[scene->shape_bag_iter++];
-
-	if (scene->shape_bag_iter >= scene->shape_bag_rand)
-		play_shuffle(scene);
-
-	scene->shape.x = 3;
-	scene->shape.y = 0;
-
-	/* If we can't spawn, that's dead! */
-	if (!board_check(scene->board, &scene->shape)) {
-		scene->state = DEAD;
-
-		/*
-		 * Animate a line per line full board from bottom to top
-		 * gradually
-		 */
-		for (int r = BOARD_H - 1; r >= 0; --r) {
-			sound_play(SOUND_TICK);
-
-			for (int c = 0; c < BOARD_W; ++c)
-				scene->board[r][c] = 11;
-
-			play_update_board(scene, 0, 0);
-			coroutine_sleep(40);
-		}
-
-		coroutine_sleep(500);
-	} else {
-		board_set(scene->board, &scene->shape);
-		play_update_next_shape(scene);
-	}
-}
-
-static int
-play_fall(struct scene *scene)
-{
-	int ret = 0;
-
-	board_unset(scene->board, &scene->shape);
-
-	if (play_can_move(scene, 0, 1)) {
-		scene->shape.y += 1;
-		ret = 1;
-	}
-
-	board_set(scene->board, &scene->shape);
-
-	return ret;
-}
-
-static void
-play_cleanup(struct scene *scene)
-{
-	static const unsigned int alpharamp[] = {
-		255, 230, 205, 180, 155, 130, 105,  80,
-		 55,  30,   5,  30,  55,  80, 105, 130,
-		155, 180, 205, 230, 255, 205, 155, 105,
-		 55,   5,  55, 105, 155, 205, 255,   0,
-		255,   0, 255,   0, 255,   0,   0, 255
-	};
-
-	unsigned int columns, count = 0;
-	unsigned int lines = 0;
-
-	/* This is a bitmask of lines full. */
-	lines = 0;
-
-	for (int r = 0; r < BOARD_H; ++r) {
-		columns = 0;
-
-		for (int c = 0; c < BOARD_W; ++c)
-			if (scene->board[r][c])
-				columns++;
-
-		if (columns >= BOARD_W) {
-			lines |= 1 << r;
-			count++;
-		}
-	}
-
-	if (count) {
-		scene->lines += count;
-
-		/* Recompute level but cap to 10. */
-		if (scene->lines >= 100)
-			scene->level = 10;
-
-		scene->level = (scene->lines / 10) + 1;
-
-		play_update_stat(scene);
-		sound_play(SOUND_CLEAN);
-
-		/* Animate pending lines. */
-		scene->state = ANIMATING;
-
-		for (size_t i = 0; i < LEN(alpharamp); ++i) {
-			play_update_board(scene, lines, alpharamp[i]);
-			coroutine_sleep(20);
-		}
-
-		for (int i = 0; i < BOARD_H; ++i)
-			if ((lines >> i) & 1)
-				board_pop(scene->board, i);
-
-		scene->state = RUNNING;
-	}
-
-	play_spawn(scene);
-}
-
 static void
 play_logic_entry(struct coroutine *self)
 {
 	struct scene *scene;
-	int level;
 
 	scene = SCENE(self, logic);
 
-	switch (scene->mode) {
-	case MODE_EXTENDED:
-		scene->shape_bag_rand = SHAPE_RAND_EXTENDED;
-		break;
-	case MODE_NIGHTMARE:
-		scene->shape_bag_rand = SHAPE_RAND_NIGHTMARE;
-
-		for (int r = 16; r < BOARD_H; ++r)
-			for (int c = 0; c < BOARD_W; ++c)
-				if (nrand(0, 1) == 0)
-					scene->board[r][c] = nrand(0, LEN(scene->shapes) - 1);
-		break;
-	default:
-		scene->shape_bag_rand = SHAPE_RAND_STANDARD;
-		break;
-	}
-
-	play_shuffle(scene);
-
-	play_init_shapes(scene);
-	play_init_bg(scene);
-	play_init_fg(scene);
-	play_init_stat(scene);
-	play_init_next(scene);
-	play_init_pause(scene);
-
-	play_spawn(scene);
-
 	while (scene->state == RUNNING) {
-		play_update_board(scene, 0, 0);
+		/* Input coroutine may end the game as well. */
+		if (scene->game.state == GAME_STATE_OVER) {
+			play_dead(scene);
+			break;
+		}
 
-		/* Wait for fall, cap to level 10. */
-		level = fmin(scene->level, 10);
-		coroutine_sleep(FALLRATE_INIT - (level * FALLRATE_DECR));
+		coroutine_yield();
 
-		if (!play_fall(scene))
-			play_cleanup(scene);
+		/* Terminated from the pause menu. */
+		if (scene->state != RUNNING)
+			break;
+
+		play_update(scene, play_advance(scene, stris.clock));
 	}
 }
 
@@ -668,6 +770,8 @@ play_logic_terminate(struct coroutine *self)
 	node_finish(&scene->pause);
 	node_finish(&scene->bg);
 	node_finish(&scene->fg);
+	node_finish(&scene->ghost);
+	node_finish(&scene->piece);
 
 	node_finish(&scene->lbl_lines.node);
 	texture_finish(&scene->lbl_lines.texture);
@@ -675,16 +779,18 @@ play_logic_terminate(struct coroutine *self)
 	node_finish(&scene->lbl_level.node);
 	texture_finish(&scene->lbl_level.texture);
 
-	for (size_t i = 0; i < LEN(scene->shapes); ++i)
-		texture_finish(&scene->shapes[i]);
+	texture_finish(&scene->blocks);
+	free(scene->quads);
 
 	node_finish(&scene->next);
 
 	/* Save scores. */
 	SDL_strlcpy(score.who, username(), sizeof (score.who));
-	score.lines = scene->lines;
+	score.lines = scene->game.lines;
 
-	if (scene->state == DEAD) {
+	/* Custom boards are not comparable with the default one. */
+	if (scene->state == DEAD &&
+	    scene->game.board.w == BOARD_W && scene->game.board.h == BOARD_H) {
 		score_read(&list, score_path(scene->mode));
 		score_add(&list, &score);
 		score_write(&list, score_path(scene->mode));
@@ -702,14 +808,49 @@ play_run(enum mode mode)
 
 	scene = alloc(1, sizeof (*scene));
 	scene->mode = mode;
-	scene->level = 1;
+	scene->game.seed = rng_entropy();
+	scene->game.w = sconf.board_w;
+	scene->game.h = sconf.board_h;
+	scene->game.randomizer = QUEUE_MODE_BAG_EXTRAS;
+	scene->game.lookahead = LOOKAHEAD;
+	scene->game.clear_delay = GAME_CLEAR_DELAY;
+	scene->game.das = sconf.das;
+	scene->game.arr = sconf.arr;
+
+	switch (mode) {
+	case MODE_EXTENDED:
+		scene->game.rand = SHAPE_RAND_EXTENDED;
+		break;
+	case MODE_NIGHTMARE:
+		scene->game.rand = SHAPE_RAND_NIGHTMARE;
+		scene->game.garbage = 4;
+		break;
+	default:
+		scene->game.rand = SHAPE_RAND_STANDARD;
+		break;
+	}
+
+	game_init(&scene->game);
+
+	play_init_blocks(scene);
+	play_init_bg(scene);
+	play_init_fg(scene);
+	play_init_piece(scene);
+	play_init_stat(scene);
+	play_init_next(scene);
+	play_init_pause(scene);
+	play_update_board(scene, 0, 0);
+
+	scene->time = stris.clock;
 
 	/* logic handler */
 	scene->logic.entry = play_logic_entry;
 	scene->logic.terminate = play_logic_terminate;
+	scene->logic.prio = COROUTINE_PRIO_LOGIC;
 	coroutine_init(&scene->logic);
 
-	/* input handler */
+	/* input handler, see play_input_entry */
 	scene->input.entry = play_input_entry;
+	scene->input.prio = COROUTINE_PRIO_INPUT;
 	coroutine_init(&scene->input);
 }
@@ -212,5 +212,6 @@ scores_run(void)
 	scores = alloc(1, sizeof (*scores));
 	scores->coroutine.entry = scores_entry;
 	scores->coroutine.terminate = scores_terminate;
+	scores->coroutine.prio = COROUTINE_PRIO_LOGIC;
 	coroutine_init(&scores->coroutine);
 }
@@ -35,9 +35,16 @@ enum item {
 	ITEM_SOUND,
 	ITEM_PSYCHEDELIC,
 	ITEM_SCALE,
+	ITEM_PACER,
+	ITEM_DAS,
+	ITEM_ARR,
 	ITEM_LAST
 };
 
+/* Choices in milliseconds for the auto shift delay and rate. */
+static const int das[] = { 0, 100, 133, 170, 200, 250 };
+static const int arr[] = { 0, 17, 33, 50, 83 };
+
 struct value {
 	struct texture texture;
 	struct node node;
@@ -75,6 +82,19 @@ settings_valuize(struct settings *settings, size_t row, const char *fmt, ...)
 	value->node.y = settings->items[row].node.y;
 }
 
+/*
+ * Return the choice following the current value, wrapping to the first one.
+ */
+static int
+settings_next(int value, const int *choices, size_t choicesz)
+{
+	for (size_t i = 0; i < choicesz; ++i)
+		if (choices[i] > value)
+			return choices[i];
+
+	return choices[0];
+}
+
 static void
 settings_entry(struct coroutine *self)
 {
@@ -84,6 +104,9 @@ settings_entry(struct coroutine *self)
 	settings->items[ITEM_SOUND].text = "Sounds";
 	settings->items[ITEM_PSYCHEDELIC].text = "Psychedelic";
 	settings->items[ITEM_SCALE].text = "Scaling";
+	settings->items[ITEM_PACER].text = "Low latency";
+	settings->items[ITEM_DAS].text = "Shift delay";
+	settings->items[ITEM_ARR].text = "Shift rate";
 
 	settings->list.font = UI_FONT_MENU_SMALL;
 	settings->list.items = settings->items;
@@ -105,6 +128,16 @@ settings_entry(struct coroutine *self)
 		settings_valuize(settings, ITEM_SOUND, sconf.sound ? "Yes" : "No");
 		settings_valuize(settings, ITEM_PSYCHEDELIC, sconf.psychedelic ? "Yes" : "No");
 		settings_valuize(settings, ITEM_SCALE, "%d", sconf.scale);
+		settings_valuize(settings, ITEM_PACER, sconf.pacer ? "Yes" : "No");
+
+		if (sconf.das)
+			settings_valuize(settings, ITEM_DAS, "%d ms", sconf.das);
+		else
+			settings_valuize(settings, ITEM_DAS, "Off");
+		if (sconf.arr)
+			settings_valuize(settings, ITEM_ARR, "%d ms", sconf.arr);
+		else
+			settings_valuize(settings, ITEM_ARR, "Instant");
 
 		switch (list_wait(&settings->list)) {
 		case ITEM_SOUND:
@@ -120,6 +153,16 @@ settings_entry(struct coroutine *self)
 			sconf.scale = clamp((++sconf.scale % 3), 1, 2);
 			ui_resize();
 			break;
+		case ITEM_PACER:
+			sconf.pacer = !sconf.pacer;
+			stris_pace();
+			break;
+		case ITEM_DAS:
+			sconf.das = settings_next(sconf.das, das, LEN(das));
+			break;
+		case ITEM_ARR:
+			sconf.arr = settings_next(sconf.arr, arr, LEN(arr));
+			break;
 		default:
 			running = 0;
 			break;
@@ -152,5 +195,6 @@ settings_run(void)
 	settings = alloc(1, sizeof (*settings));
 	settings->coroutine.entry = settings_entry;
 	settings->coroutine.terminate = settings_terminate;
+	settings->coroutine.prio = COROUTINE_PRIO_LOGIC;
 	coroutine_init(&settings->coroutine);
 }
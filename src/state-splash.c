@@ -40,7 +40,7 @@ struct splash {
 static void
 splash_entry(struct coroutine *self)
 {
-	struct texture texture;
+	struct texture texture = {};
 	struct splash *splash;
 
 	splash = SPLASH(self, coroutine);
@@ -88,5 +88,6 @@ splash_run(void)
 	splash = alloc(1, sizeof (*splash));
 	splash->coroutine.entry = splash_entry;
 	splash->coroutine.terminate = splash_terminate;
+	splash->coroutine.prio = COROUTINE_PRIO_LOGIC;
 	coroutine_init(&splash->coroutine);
 }
@@ -20,13 +20,15 @@
 #include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
-#include <time.h>
+#include <string.h>
 
 #define SDL_MAIN_USE_CALLBACKS
 #include <SDL3/SDL.h>
 #include <SDL3/SDL_main.h>
 
+#include "board.h"
 #include "coroutine.h"
+#include "game.h"
 #include "joy.h"
 #include "node.h"
 #include "sound.h"
@@ -39,13 +41,81 @@
 struct sconf sconf = {
 	.sound = 0,
 	.psychedelic = 1,
-	.scale = 1
+	.scale = 1,
+	.das = GAME_DAS,
+	.arr = GAME_ARR,
+	.board_w = BOARD_W,
+	.board_h = BOARD_H
 };
 
+/*
+ * Safety margin in nanoseconds kept before the present deadline when
+ * pacing frames, it absorbs the scheduler wake up jitter.
+ */
+#define PACE_MARGIN SDL_MS_TO_NS(1)
+
 struct stris stris = {
 	.run = 1
 };
 
+static void
+usage(void)
+{
+	die("usage: stris [-h rows] [-w columns]\n");
+}
+
+static int
+parse_size(const char *arg, int min, int max)
+{
+	char *end;
+	long v;
+
+	v = strtol(arg, &end, 10);
+
+	if (*end || v < min || v > max)
+		die("abort: %s: invalid size (%d..%d)\n", arg, min, max);
+
+	return v;
+}
+
+static void
+parse_args(int argc, char **argv)
+{
+	for (int i = 1; i < argc; ++i) {
+		if (strcmp(argv[i], "-w") == 0 && i + 1 < argc)
+			sconf.board_w = parse_size(argv[++i], BOARD_W_MIN, BOARD_W_MAX);
+		else if (strcmp(argv[i], "-h") == 0 && i + 1 < argc)
+			sconf.board_h = parse_size(argv[++i], BOARD_H_MIN, BOARD_H_MAX);
+		else
+			usage();
+	}
+}
+
+static void
+push(enum key key, int state, uint64_t time)
+{
+	struct input *in;
+
+	/*
+	 * Only record transitions, the same key may be held from the keyboard
+	 * and the gamepad at once.
+	 */
+	if (!key || !state == !(stris.keys & key))
+		return;
+
+	if (state)
+		stris.keys |= key;
+	else
+		stris.keys &= ~key;
+
+	in = &stris.inputs[stris.inputs_count++ % LEN(stris.inputs)];
+	in->key = key;
+	in->down = state;
+	in->time = time;
+
+	coroutine_notify_input();
+}
+
 static void
 handle_controller_axis_motion(const SDL_GamepadAxisEvent *ev)
 {
@@ -96,10 +166,7 @@ handle_controller_axis_motion(const SDL_GamepadAxisEvent *ev)
 		break;
 	}
 
-	if (state)
-		stris.keys |= key;
-	else
-		stris.keys &= ~key;
+	push(key, state, ev->timestamp);
 }
 
 static void
@@ -134,10 +201,7 @@ handle_controller_button(const SDL_GamepadButtonEvent *ev)
 		break;
 	}
 
-	if (state)
-		stris.keys |= key;
-	else
-		stris.keys &= ~key;
+	push(key, state, ev->timestamp);
 }
 
 static void
@@ -146,6 +210,9 @@ handle_keyboard(const SDL_KeyboardEvent *ev)
 	int state = ev->type == SDL_EVENT_KEY_DOWN;
 	enum key key = KEY_NONE;
 
+	if (ev->repeat)
+		return;
+
 	switch (ev->scancode) {
 	case SDL_SCANCODE_ESCAPE:
 		key = KEY_CANCEL;
@@ -176,28 +243,122 @@ handle_keyboard(const SDL_KeyboardEvent *ev)
 		break;
 	}
 
-	if (state)
-		stris.keys |= key;
-	else
-		stris.keys &= ~key;
+	push(key, state, ev->timestamp);
+}
+
+static SDL_AppResult
+handle_event(const SDL_Event *ev)
+{
+	switch (ev->type) {
+	case SDL_EVENT_QUIT:
+		return SDL_APP_SUCCESS;
+	case SDL_EVENT_GAMEPAD_AXIS_MOTION:
+		handle_controller_axis_motion(&ev->gaxis);
+		break;
+	case SDL_EVENT_GAMEPAD_BUTTON_DOWN:
+	case SDL_EVENT_GAMEPAD_BUTTON_UP:
+		handle_controller_button(&ev->gbutton);
+		break;
+	case SDL_EVENT_KEY_DOWN:
+	case SDL_EVENT_KEY_UP:
+		handle_keyboard(&ev->key);
+		break;
+	case SDL_EVENT_WINDOW_DISPLAY_CHANGED:
+	case SDL_EVENT_DISPLAY_CURRENT_MODE_CHANGED:
+		stris_pace();
+		break;
+	case SDL_EVENT_WINDOW_EXPOSED:
+	case SDL_EVENT_WINDOW_PIXEL_SIZE_CHANGED:
+	case SDL_EVENT_RENDER_TARGETS_RESET:
+	case SDL_EVENT_RENDER_DEVICE_RESET:
+		stris.dirty = 1;
+		break;
+	default:
+		break;
+	}
+
+	return SDL_APP_CONTINUE;
+}
+
+int
+stris_poll(struct input *in)
+{
+	assert(in);
+
+	struct coroutine *co;
+
+	co = coroutine_self();
+
+	/* Skip what was overwritten in the meantime. */
+	if (stris.inputs_count - co->input > LEN(stris.inputs))
+		co->input = stris.inputs_count - LEN(stris.inputs);
+	if (co->input == stris.inputs_count)
+		return 0;
+
+	*in = stris.inputs[co->input++ % LEN(stris.inputs)];
+
+	return 1;
 }
 
 enum key
 stris_pressed(void)
 {
-	enum key current, diff;
+	struct input in;
 
-	current = stris.keys;
+	for (;;) {
+		while (stris_poll(&in))
+			if (in.down)
+				return in.key;
 
-	/* Yield until only a new bit is pressent in stris.keys */
-	while ((current | stris.keys) == current) {
-		current = stris.keys;
-		coroutine_yield();
+		coroutine_wait_input();
 	}
+}
+
+/*
+ * Sleep until the frame can still be rendered in time for the next refresh,
+ * then handle the events received meanwhile so that the frame uses the latest
+ * input possible. Leaving them to SDL_AppEvent would only deliver them after
+ * this frame.
+ */
+static void
+pace(void)
+{
+	SDL_Event ev;
+	uint64_t period, budget, wake, now;
+
+	period = ui_refresh();
+	budget = stris.cost + PACE_MARGIN;
+
+	/* Rendering takes the whole refresh, nothing to win. */
+	if (budget >= period)
+		return;
+
+	wake = stris.vblank + period - budget;
+	now = SDL_GetTicksNS();
+
+	if (wake > now)
+		SDL_DelayPrecise(wake - now);
+
+	while (SDL_PollEvent(&ev))
+		if (handle_event(&ev) == SDL_APP_SUCCESS)
+			stris_quit();
+}
 
-	diff = current ^ stris.keys;
+void
+stris_pace(void)
+{
+	char rate[32] = "0";
+
+	/*
+	 * With pacing VSync alone throttles the loop and the callback is
+	 * called right away, otherwise SDL calls it at the display refresh
+	 * rate so that the falling shape moves on every refresh.
+	 */
+	if (!sconf.pacer)
+		snprintf(rate, sizeof (rate), "%.3f",
+		    (double)SDL_NS_PER_SECOND / ui_refresh());
 
-	return diff;
+	SDL_SetHint(SDL_HINT_MAIN_CALLBACK_RATE, rate);
 }
 
 void
@@ -207,21 +368,23 @@ stris_quit(void)
 }
 
 SDL_AppResult
-SDL_AppInit(void **, int, char **)
+SDL_AppInit(void **, int argc, char **argv)
 {
-	srand(time(NULL));
+	parse_args(argc, argv);
+	sys_conf_read();
 
-	SDL_SetHint(SDL_HINT_MAIN_CALLBACK_RATE, "60.0");
 	SDL_SetHint(SDL_HINT_RENDER_VSYNC, "1");
 
-	sys_conf_read();
 	ui_init();
 	joy_init();
+	stris_pace();
 
 	if (sconf.sound)
 		sound_init();
 
 	splash_run();
+	stris.clock = stris.vblank = SDL_GetTicksNS();
+	stris.cost = SDL_MS_TO_NS(2);
 
 	return SDL_APP_CONTINUE;
 }
@@ -229,24 +392,68 @@ SDL_AppInit(void **, int, char **)
 SDL_AppResult
 SDL_AppIterate(void *)
 {
+	uint64_t now, cost, start, period;
+	unsigned int dt;
+
+	if (sconf.pacer)
+		pace();
 	if (!stris.run)
 		return SDL_APP_SUCCESS;
 
-	for (size_t i = 0; i < LEN(stris.coroutines); ++i) {
-		if (!stris.coroutines[i] || stris.coroutines[i]->pause)
-			continue;
+	/*
+	 * Give the real time elapsed to coroutines whatever the refresh rate
+	 * is, the sub-millisecond remainder is kept for the next frame.
+	 */
+	now = SDL_GetTicksNS();
+	stris.lag += now - stris.clock;
+	stris.clock = now;
+
+	if (stris.lag > FRAME_MAX)
+		stris.lag = FRAME_MAX;
+
+	dt = stris.lag / SDL_NS_PER_MS;
+	stris.lag %= SDL_NS_PER_MS;
+
+	/* Whatever rendering does not need is for the coroutines. */
+	period = ui_refresh();
+	coroutine_run(dt, now + period - SDL_min(stris.render, period));
+
+	/* Nodes are changed directly, compare them with the last frame. */
+	for (struct node *node = stris.nodes.first; node && !stris.dirty; node = node->next)
+		if (node_changed(node))
+			stris.dirty = 1;
+
+	/*
+	 * Nothing changed, the last frame stays on screen. Without pacing the
+	 * callback rate already spaces the calls, otherwise nothing blocks
+	 * anymore so wait for an event up to a refresh period.
+	 */
+	if (!stris.dirty) {
+		if (sconf.pacer)
+			SDL_WaitEventTimeout(NULL, period / SDL_NS_PER_MS);
 
-		if (coroutine_resume(stris.coroutines[i], 16))
-			coroutine_finish(stris.coroutines[i]);
+		return SDL_APP_CONTINUE;
 	}
 
+	start = SDL_GetTicksNS();
 	ui_clear(0xffffffff);
 
-	for (size_t i = 0; i < LEN(stris.nodes); ++i)
-		if (stris.nodes[i])
-			node_render(stris.nodes[i]);
+	for (struct node *node = stris.nodes.first; node; node = node->next)
+		node_render(node);
+
+	cost = SDL_GetTicksNS() - start;
+	stris.render = stris.render - stris.render / 8 + cost / 8;
+
+	/*
+	 * Moving average of the time needed to produce a frame, present itself
+	 * is not accounted as it blocks until the refresh.
+	 */
+	cost = SDL_GetTicksNS() - now;
+	stris.cost = stris.cost - stris.cost / 8 + cost / 8;
 
 	ui_present();
+	stris.vblank = SDL_GetTicksNS();
+	stris.dirty = 0;
 
 	return SDL_APP_CONTINUE;
 }
@@ -254,25 +461,7 @@ SDL_AppIterate(void *)
 SDL_AppResult
 SDL_AppEvent(void *, SDL_Event *ev)
 {
-	switch (ev->type) {
-	case SDL_EVENT_QUIT:
-		return SDL_APP_SUCCESS;
-	case SDL_EVENT_GAMEPAD_AXIS_MOTION:
-		handle_controller_axis_motion(&ev->gaxis);
-		break;
-	case SDL_EVENT_GAMEPAD_BUTTON_DOWN:
-	case SDL_EVENT_GAMEPAD_BUTTON_UP:
-		handle_controller_button(&ev->gbutton);
-		break;
-	case SDL_EVENT_KEY_DOWN:
-	case SDL_EVENT_KEY_UP:
-		handle_keyboard(&ev->key);
-		break;
-	default:
-		break;
-	}
-
-	return SDL_APP_CONTINUE;
+	return handle_event(ev);
 }
 
 void
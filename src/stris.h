@@ -24,8 +24,15 @@
  * \brief Main stris file.
  */
 
+#include <stdint.h>
+
 struct node;
-struct coroutine;
+
+/**
+ * Longest frame accounted in nanoseconds, anything above (window dragged,
+ * system suspended, debugger) is not worth catching up.
+ */
+#define FRAME_MAX UINT64_C(250000000)
 
 /**
  * \enum mode
@@ -53,25 +60,80 @@ enum key : unsigned int {
 	KEY_DROP   = 1 << 6     /*!< drop shape */
 };
 
+/**
+ * \struct input
+ * \brief Key press or release as it was received.
+ */
+struct input {
+	enum key key;           /*!< key concerned */
+	int down;               /*!< non-zero if pressed */
+	uint64_t time;          /*!< SDL timestamp in nanoseconds */
+};
+
 /**
  * \struct stris
  * \brief Game object and scene rendering.
  */
 struct stris {
 	/**
-	 * Objects to draw on scene.
+	 * Objects to draw on scene, in registration order.
 	 */
-	struct node *nodes[32];
+	struct {
+		struct node *first;
+		struct node *last;
+	} nodes;
 
 	/**
-	 * Coroutines to manage.
+	 * Keys being pressed.
 	 */
-	struct coroutine *coroutines[16];
+	enum key keys;
 
 	/**
-	 * Keys being pressed.
+	 * Ring of the last input events, each coroutine reads it through its
+	 * own cursor so that every reader sees all of them in order.
 	 */
-	enum key keys;
+	struct input inputs[64];
+
+	/**
+	 * Total number of input events ever received, the next one is stored
+	 * at inputs[inputs_count % LEN(inputs)].
+	 */
+	uint64_t inputs_count;
+
+	/**
+	 * Monotonic time of the last frame in nanoseconds.
+	 */
+	uint64_t clock;
+
+	/**
+	 * Nanoseconds not given to the coroutines yet, only whole
+	 * milliseconds are.
+	 */
+	uint64_t lag;
+
+	/**
+	 * Time in nanoseconds the last frame was presented at.
+	 */
+	uint64_t vblank;
+
+	/**
+	 * Estimated nanoseconds from waking up to present, see
+	 * ::sconf::pacer.
+	 */
+	uint64_t cost;
+
+	/**
+	 * Estimated nanoseconds to draw the nodes, the coroutines get what is
+	 * left of the refresh period.
+	 */
+	uint64_t render;
+
+	/**
+	 * Non-zero if a texture was drawn, modulated or a node added or
+	 * removed since the last frame, frames without any change are
+	 * skipped.
+	 */
+	int dirty;
 
 	/**
 	 * Non-zero as long as application should run.
@@ -87,6 +149,11 @@ struct sconf {
 	int sound;              /*!< enable audio */
 	int psychedelic;        /*!< enable background psychedelic effect */
 	int scale;              /*!< increase window scaling */
+	int pacer;              /*!< sleep until just before present */
+	int das;                /*!< auto shift delay in milliseconds */
+	int arr;                /*!< auto shift rate in milliseconds */
+	int board_w;            /*!< board columns (command line only) */
+	int board_h;            /*!< board rows (command line only) */
 };
 
 /**
@@ -100,11 +167,30 @@ extern struct stris stris;
 extern struct sconf sconf;
 
 /**
- * Yield until a new key is pressed.
+ * Fetch the next input event not yet read by the calling coroutine.
+ *
+ * If the coroutine did not read the ring for too long, the oldest events are
+ * lost.
+ *
+ * \param in the event to fill
+ * \return non-zero if an event was available
+ */
+int
+stris_poll(struct input *in);
+
+/**
+ * Yield until a key is pressed, every press is returned exactly once and in
+ * order even if several ones happened within the same frame.
  */
 enum key
 stris_pressed(void);
 
+/**
+ * Apply the frame rate strategy from ::sconf::pacer.
+ */
+void
+stris_pace(void);
+
 /**
  * Request to quit.
  */
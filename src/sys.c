@@ -17,8 +17,10 @@
  */
 
 #if !defined(_WIN32)
+#       include <sys/mman.h>
 #       include <sys/stat.h>
 #       include <errno.h>
+#       include <unistd.h>
 #else
 #       include <windows.h>
 #       include <fileapi.h>
@@ -53,6 +55,46 @@ mkdirectory(const char *path)
 	return 0;
 }
 
+size_t
+sys_page_size(void)
+{
+	long size;
+
+	if ((size = sysconf(_SC_PAGESIZE)) <= 0)
+		return 4096;
+
+	return size;
+}
+
+void *
+sys_map_guarded(size_t size)
+{
+	void *ptr;
+
+	ptr = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANON, -1, 0);
+
+	if (ptr == MAP_FAILED)
+		return NULL;
+	if (mprotect(ptr, sys_page_size(), PROT_NONE) < 0) {
+		munmap(ptr, size);
+		return NULL;
+	}
+
+	return ptr;
+}
+
+void
+sys_release(void *ptr, size_t size)
+{
+	madvise(ptr, size, MADV_DONTNEED);
+}
+
+void
+sys_unmap(void *ptr, size_t size)
+{
+	munmap(ptr, size);
+}
+
 #else
 
 static int
@@ -64,6 +106,48 @@ mkdirectory(const char *path)
 	return 0;
 }
 
+size_t
+sys_page_size(void)
+{
+	SYSTEM_INFO info;
+
+	GetSystemInfo(&info);
+
+	return info.dwPageSize;
+}
+
+void *
+sys_map_guarded(size_t size)
+{
+	DWORD old;
+	void *ptr;
+
+	/*
+	 * Committed up front, growing on demand would need guard pages that
+	 * Windows only handles for the stack of the thread itself.
+	 */
+	if (!(ptr = VirtualAlloc(NULL, size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE)))
+		return NULL;
+	if (!VirtualProtect(ptr, sys_page_size(), PAGE_NOACCESS, &old)) {
+		VirtualFree(ptr, 0, MEM_RELEASE);
+		return NULL;
+	}
+
+	return ptr;
+}
+
+void
+sys_release(void *ptr, size_t size)
+{
+	VirtualAlloc(ptr, size, MEM_RESET, PAGE_READWRITE);
+}
+
+void
+sys_unmap(void *ptr, size_t)
+{
+	VirtualFree(ptr, 0, MEM_RELEASE);
+}
+
 #endif
 
 static int
@@ -118,11 +202,15 @@ sys_conf_read(void)
 	if (!(fp = fopen(p, "r")))
 		return;
 
-	fscanf(fp, "%d %d\n", &sconf.sound, &sconf.scale);
+	fscanf(fp, "%d %d %d %d %d\n", &sconf.sound, &sconf.scale,
+	    &sconf.pacer, &sconf.das, &sconf.arr);
 	fclose(fp);
 
 	/* Reset to normal values if invalid. */
 	sconf.scale = clamp(sconf.scale, 1, 2);
+	sconf.pacer = !!sconf.pacer;
+	sconf.das = clamp(sconf.das, 0, 1000);
+	sconf.arr = clamp(sconf.arr, 0, 1000);
 }
 
 void
@@ -136,6 +224,7 @@ sys_conf_write(void)
 	if (!(fp = fopen(p, "w")))
 		return;
 
-	fprintf(fp, "%d %d\n", sconf.sound, sconf.scale);
+	fprintf(fp, "%d %d %d %d %d\n", sconf.sound, sconf.scale,
+	    sconf.pacer, sconf.das, sconf.arr);
 	fclose(fp);
 }
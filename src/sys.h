@@ -24,6 +24,8 @@
  * \brief Operating system dependent routines.
  */
 
+#include <stddef.h>
+
 /**
  * Read system configuration and fills global ::sconf.
  */
@@ -36,4 +38,40 @@ sys_conf_read(void);
 void
 sys_conf_write(void);
 
+/**
+ * Get the size of a memory page.
+ */
+size_t
+sys_page_size(void);
+
+/**
+ * Map zero initialized memory whose first page is inaccessible, it is meant
+ * to be used as a stack growing down to it.
+ *
+ * \param size the total size including the guard page, multiple of
+ * ::sys_page_size
+ * \return the mapping start (guard page) or NULL on failure
+ */
+void *
+sys_map_guarded(size_t size);
+
+/**
+ * Give the pages of a mapping back to the system while keeping it mapped, they
+ * read as zero once used again on POSIX systems and are undefined on Windows.
+ *
+ * \param ptr the start of the pages, multiple of ::sys_page_size
+ * \param size the size in bytes, multiple of ::sys_page_size
+ */
+void
+sys_release(void *ptr, size_t size);
+
+/**
+ * Unmap memory obtained with ::sys_map_guarded.
+ *
+ * \param ptr the mapping start
+ * \param size the size given to ::sys_map_guarded
+ */
+void
+sys_unmap(void *ptr, size_t size);
+
 #endif /* !STRIS_SYS_H */
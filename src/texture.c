@@ -20,8 +20,10 @@
 #include <SDL3_image/SDL_image.h>
 
 #include <assert.h>
+#include <stdlib.h>
 #include <string.h>
 
+#include "stris.h"
 #include "texture.h"
 #include "ui.h"
 #include "util.h"
@@ -29,6 +31,10 @@
 /* private in ui.c */
 extern SDL_Renderer *ui_rdr;
 
+/* Vertices for texture_batch, kept across calls and grown on demand. */
+static SDL_Vertex *vertices;
+static size_t verticesz;
+
 void
 texture_init(struct texture *texture, unsigned int w, unsigned int h)
 {
@@ -66,6 +72,37 @@ texture_load(struct texture *texture, const void *data, size_t datasz)
 	SDL_DestroySurface(sf);
 }
 
+void
+texture_atlas(struct texture *atlas, struct texture *textures, size_t texturesz)
+{
+	assert(atlas);
+	assert(textures);
+	assert(texturesz);
+
+	unsigned int w = 0, h = 0;
+	int x = 0;
+
+	for (size_t i = 0; i < texturesz; ++i) {
+		w += textures[i].w;
+		h = textures[i].h > h ? textures[i].h : h;
+	}
+
+	texture_init(atlas, w, h);
+
+	/* Copy as is, blending on the transparent target would darken edges. */
+	UI_BEGIN(atlas);
+	ui_clear(0x00000000);
+
+	for (size_t i = 0; i < texturesz; ++i) {
+		SDL_SetTextureBlendMode(textures[i].handle, SDL_BLENDMODE_NONE);
+		texture_render(&textures[i], x, 0);
+		SDL_SetTextureBlendMode(textures[i].handle, SDL_BLENDMODE_BLEND);
+		x += textures[i].w;
+	}
+
+	UI_END();
+}
+
 void
 texture_render(struct texture *texture, int x, int y)
 {
@@ -80,6 +117,20 @@ texture_render(struct texture *texture, int x, int y)
 	});
 }
 
+void
+texture_tile(struct texture *texture, int x, int y, unsigned int w, unsigned int h)
+{
+	assert(texture);
+	assert(texture->handle);
+
+	SDL_RenderTextureTiled(ui_rdr, texture->handle, NULL, 1.0f, &(const SDL_FRect) {
+		.x = x,
+		.y = y,
+		.w = w,
+		.h = h
+	});
+}
+
 void
 texture_scale(struct texture *texture, int x, int y, unsigned int w, unsigned int h)
 {
@@ -100,31 +151,96 @@ texture_scale(struct texture *texture, int x, int y, unsigned int w, unsigned in
 	SDL_RenderTexture(ui_rdr, texture->handle, &rsrc, &rdst);
 }
 
+void
+texture_batch(struct texture *texture, const struct texture_quad *quads, size_t quadsz)
+{
+	assert(texture);
+	assert(texture->handle);
+	assert(quads);
+
+	const struct texture_quad *q;
+	SDL_Vertex *v;
+	float u0, v0, u1, v1, x0, y0, x1, y1;
+	SDL_FColor color;
+
+	if (!quadsz)
+		return;
+
+	/* Two triangles per quad, no index buffer needed. */
+	if (verticesz < quadsz * 6) {
+		free(vertices);
+		verticesz = quadsz * 6;
+		vertices = alloc(verticesz, sizeof (*vertices));
+	}
+
+	for (size_t i = 0; i < quadsz; ++i) {
+		q = &quads[i];
+		v = &vertices[i * 6];
+
+		u0 = (float)q->sx / texture->w;
+		v0 = (float)q->sy / texture->h;
+		u1 = (float)(q->sx + q->sw) / texture->w;
+		v1 = (float)(q->sy + q->sh) / texture->h;
+		x0 = q->x;
+		y0 = q->y;
+		x1 = q->x + (int)q->w;
+		y1 = q->y + (int)q->h;
+		color = (SDL_FColor) { 1.0f, 1.0f, 1.0f, q->alpha / 255.0f };
+
+		v[0] = (SDL_Vertex) { { x0, y0 }, color, { u0, v0 } };
+		v[1] = (SDL_Vertex) { { x1, y0 }, color, { u1, v0 } };
+		v[2] = (SDL_Vertex) { { x1, y1 }, color, { u1, v1 } };
+		v[3] = v[0];
+		v[4] = v[2];
+		v[5] = (SDL_Vertex) { { x0, y1 }, color, { u0, v1 } };
+	}
+
+	if (!SDL_RenderGeometry(ui_rdr, texture->handle, vertices, quadsz * 6, NULL, 0))
+		die("abort: SDL_RenderGeometry: %s\n", SDL_GetError());
+}
+
 void
 texture_alpha(struct texture *texture, unsigned int alpha)
 {
 	assert(texture);
 	assert(texture->handle);
 
+	uint8_t old;
+
+	/* Animations set it at every step, only a change needs a frame. */
+	if (SDL_GetTextureAlphaMod(texture->handle, &old) && old == alpha)
+		return;
+
 	SDL_SetTextureAlphaMod(texture->handle, alpha);
+	stris.dirty = 1;
 }
 
 static inline void
 texture_colorize(struct texture *texture, int blend, uint32_t color)
 {
-	uint8_t r, g, b;
+	uint8_t r, g, b, oldr, oldg, oldb;
+	SDL_BlendMode old;
+
+	r = UI_COLOR_R(color);
+	g = UI_COLOR_G(color);
+	b = UI_COLOR_B(color);
+
+	/* Same as before, like texture_alpha there is nothing to redraw. */
+	if (SDL_GetTextureBlendMode(texture->handle, &old) &&
+	    SDL_GetTextureColorMod(texture->handle, &oldr, &oldg, &oldb) &&
+	    old == (SDL_BlendMode)blend &&
+	    (blend == SDL_BLENDMODE_NONE || (oldr == r && oldg == g && oldb == b)))
+		return;
 
 	if (!SDL_SetTextureBlendMode(texture->handle, blend))
 		die("SDL_SetTextureBlendMode: %s\n", SDL_GetError());
 
 	if (blend != SDL_BLENDMODE_NONE) {
-		r = UI_COLOR_R(color);
-		g = UI_COLOR_G(color);
-		b = UI_COLOR_B(color);
-
 		if (!SDL_SetTextureColorMod(texture->handle, r, g, b))
 			die("SDL_SetTextureColorMod: %s\n", SDL_GetError());
 	}
+
+	stris.dirty = 1;
 }
 
 void
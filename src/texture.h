@@ -44,6 +44,22 @@ struct texture {
 	void *handle;   /* SDL_Texture */
 };
 
+/**
+ * \struct texture_quad
+ * \brief Region of a texture drawn by ::texture_batch.
+ */
+struct texture_quad {
+	int sx;                 /*!< source column */
+	int sy;                 /*!< source row */
+	unsigned int sw;        /*!< source width */
+	unsigned int sh;        /*!< source height */
+	int x;                  /*!< destination column */
+	int y;                  /*!< destination row */
+	unsigned int w;         /*!< destination width */
+	unsigned int h;         /*!< destination height */
+	unsigned int alpha;     /*!< transparency (in range 0..255) */
+};
+
 /**
  * Create a new empty texture.
  *
@@ -67,18 +83,48 @@ texture_init(struct texture *texture, unsigned int width, unsigned int height);
 void
 texture_load(struct texture *texture, const void *data, size_t datasz);
 
+/**
+ * Pack several textures side by side into a new one.
+ *
+ * The texture i starts at the column equal to the sum of the widths of the
+ * previous ones, the sources can be destroyed afterwards.
+ *
+ * \param textures the textures to copy (not NULL)
+ * \param texturesz the number of textures
+ */
+void
+texture_atlas(struct texture *atlas, struct texture *textures, size_t texturesz);
+
 /**
  * Draw the texture 1:1 at the x;y coordinates.
  */
 void
 texture_render(struct texture *texture, int x, int y);
 
+/**
+ * Repeat the texture 1:1 to fill w:h at the x;y coordinates.
+ */
+void
+texture_tile(struct texture *texture, int x, int y, unsigned int w, unsigned int h);
+
 /**
  * Scale the texture to w:h at the x;y coordinates.
  */
 void
 texture_scale(struct texture *texture, int x, int y, unsigned int w, unsigned int h);
 
+/**
+ * Draw several regions of the texture at once.
+ *
+ * All quads are submitted as a single geometry so the renderer issues one
+ * draw call, each quad carries its own transparency.
+ *
+ * \param quads the regions to draw (not NULL)
+ * \param quadsz the number of regions
+ */
+void
+texture_batch(struct texture *texture, const struct texture_quad *quads, size_t quadsz);
+
 /**
  * Change texture transparency.
  *
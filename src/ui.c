@@ -42,12 +42,23 @@
 
 static struct texture *target;
 
+/* Glyphs are rasterized once in its atlas and then drawn as quads. */
+static TTF_TextEngine *engine;
+
 SDL_Window *ui_win = NULL;
 SDL_Renderer *ui_rdr = NULL;
 
+/*
+ * Size of a grid background square, the pattern repeats every two squares
+ * and looks the same once moved by one square in both directions.
+ */
+#define BG_SQUARE (UI_W / 10)
+
 /* Grid background. */
 static struct {
 	uint32_t target;
+	uint32_t color;
+	struct texture tile;
 	struct node background;
 	struct coroutine updater;
 } bg;
@@ -57,6 +68,7 @@ static struct {
 	size_t datasz;
 	int size;
 	TTF_Font *font;
+	TTF_Text *text;
 } fonts[] = {
 	[UI_FONT_SPLASH] = {
 		.data = assets_fonts_typography_ties,
@@ -102,46 +114,53 @@ load_font(const unsigned char *data, size_t datasz, int size)
 static void
 init_fonts(void)
 {
-	for (size_t i = 0; i < LEN(fonts); ++i)
+	if (!(engine = TTF_CreateRendererTextEngine(ui_rdr)))
+		die("abort: %s\n", SDL_GetError());
+
+	/* One text object per font, only its string changes afterwards. */
+	for (size_t i = 0; i < LEN(fonts); ++i) {
 		fonts[i].font = load_font(fonts[i].data, fonts[i].datasz, fonts[i].size);
+
+		if (!(fonts[i].text = TTF_CreateText(engine, fonts[i].font, "", 0)))
+			die("abort: %s\n", SDL_GetError());
+	}
 }
 
+/*
+ * The pattern is a single tile colorized by the texture color modulation,
+ * scrolling only moves the node.
+ */
 static void
-ui_bg_updater_entry(struct coroutine *)
+ui_bg_render(struct node *self)
 {
-	struct texture texture;
+	texture_tile(self->texture, self->x, self->y,
+	    UI_W + BG_SQUARE, UI_H + BG_SQUARE);
+}
+
+static int
+ui_bg_updater_step(struct coroutine *self)
+{
+	struct node *node = &bg.background;
 	int rcur, gcur, bcur;
 	int rnxt, gnxt, bnxt;
-	uint32_t color, darken;
-	int w, h, x, y, r, g, b;
-
-	/* Initial color. */
-	bg.target = color = UI_PALETTE_MENU_BG;
-
-	/* Size of individual square */
-	w = h = UI_W / 10;
 
-	/* Prepare background texture. */
-	texture_init(&texture, UI_W, UI_H);
-	node_wrap(&bg.background, &texture);
-
-	x = y = 0;
+	COROUTINE_BEGIN(self);
 
 	for (;;) {
-		coroutine_sleep(50);
+		COROUTINE_SLEEP(self, 50);
 
 		if (sconf.psychedelic) {
-			x--;
-			y--;
+			node->x--;
+			node->y--;
 		} else
-			x = y = 0;
+			node->x = node->y = 0;
 
 		/* Gradually reach the target color. */
-		rcur = UI_COLOR_R(color); rnxt = UI_COLOR_R(bg.target);
-		gcur = UI_COLOR_G(color); gnxt = UI_COLOR_G(bg.target);
-		bcur = UI_COLOR_B(color); bnxt = UI_COLOR_B(bg.target);
+		rcur = UI_COLOR_R(bg.color); rnxt = UI_COLOR_R(bg.target);
+		gcur = UI_COLOR_G(bg.color); gnxt = UI_COLOR_G(bg.target);
+		bcur = UI_COLOR_B(bg.color); bnxt = UI_COLOR_B(bg.target);
 
-		if (color != bg.target) {
+		if (bg.color != bg.target) {
 			if (rcur != rnxt)
 				rcur += (rcur < rnxt) ? 1 : -1;
 			if (gcur != gnxt)
@@ -149,56 +168,110 @@ ui_bg_updater_entry(struct coroutine *)
 			if (bcur != bnxt)
 				bcur += (bcur < bnxt) ? 1 : -1;
 
-			color = UI_COLOR(rcur, gcur, bcur, 0xff);
+			bg.color = UI_COLOR(rcur, gcur, bcur, 0xff);
+			texture_color_blend(&bg.tile, bg.color);
 		}
 
-		if (x == -w)
-			x = y = 0;
-
-		UI_BEGIN(bg.background.texture);
-		ui_clear(color);
-
-		/* Darken color for grid pattern. */
-		r = clamp((long)UI_COLOR_R(color) - 10, 0, 255);
-		g = clamp((long)UI_COLOR_G(color) - 10, 0, 255);
-		b = clamp((long)UI_COLOR_B(color) - 10, 0, 255);
-		darken = UI_COLOR(r, g, b, 0xff);
-
-		for (int r = 0; r < 21; ++r)
-			for (int c = 0; c < 11; c += 2)
-				ui_draw_rect(darken, (x + w * c) + (r % 2 == 0 ? w : 0), (y + h * r), w, h);
-
-		UI_END();
+		if (node->x == -BG_SQUARE)
+			node->x = node->y = 0;
 	}
+
+	COROUTINE_END(self);
 }
 
 static void
 init_bg(void)
 {
-	bg.updater.entry = ui_bg_updater_entry;
+	/*
+	 * The tile is drawn once in white and light grey, the color
+	 * modulation gives the actual color and its darker squares.
+	 */
+	texture_init(&bg.tile, BG_SQUARE * 2, BG_SQUARE * 2);
+
+	UI_BEGIN(&bg.tile);
+	ui_clear(0xffffffff);
+	ui_draw_rect(0xf0f0f0ff, BG_SQUARE, 0, BG_SQUARE, BG_SQUARE);
+	ui_draw_rect(0xf0f0f0ff, 0, BG_SQUARE, BG_SQUARE, BG_SQUARE);
+	UI_END();
+
+	bg.target = bg.color = UI_PALETTE_MENU_BG;
+	texture_color_blend(&bg.tile, bg.color);
+
+	bg.background.texture = &bg.tile;
+	bg.background.render = ui_bg_render;
+	node_init(&bg.background);
+
+	bg.updater.step = ui_bg_updater_step;
+	bg.updater.prio = COROUTINE_PRIO_COSMETIC;
 	coroutine_init(&bg.updater);
 }
 
 static inline void
 finish_fonts(void)
 {
-	for (size_t i = 0; i < LEN(fonts); ++i)
+	for (size_t i = 0; i < LEN(fonts); ++i) {
+		TTF_DestroyText(fonts[i].text);
 		TTF_CloseFont(fonts[i].font);
+	}
+
+	TTF_DestroyRendererTextEngine(engine);
 }
 
-static inline void
-ui_vclip(enum ui_font font, unsigned int *w, unsigned int *h, const char *fmt, va_list ap)
+/*
+ * Format the string into the text object of the font and get its dimensions,
+ * this only shapes the glyphs without rendering anything.
+ */
+static TTF_Text *
+ui_vtext(enum ui_font f, unsigned int *w, unsigned int *h, const char *fmt, va_list ap)
 {
-	struct texture texture;
+	char str[128] = {};
+	int tw, th;
+
+	vsnprintf(str, sizeof (str), fmt, ap);
 
-	ui_vprintf(&texture, font, 0, fmt, ap);
+	if (!TTF_SetTextString(fonts[f].text, str, 0))
+		die("abort: %s\n", SDL_GetError());
+	if (!TTF_GetTextSize(fonts[f].text, &tw, &th))
+		die("abort: %s\n", SDL_GetError());
 
 	if (w)
-		*w = texture.w;
+		*w = tw;
 	if (h)
-		*h = texture.h;
+		*h = th;
+
+	return fonts[f].text;
+}
+
+static inline void
+ui_text_draw(TTF_Text *text, uint32_t color, int x, int y)
+{
+	TTF_SetTextColor(text,
+	    UI_COLOR_R(color),
+	    UI_COLOR_G(color),
+	    UI_COLOR_B(color),
+	    UI_COLOR_A(color)
+	);
 
-	texture_finish(&texture);
+	if (!TTF_DrawRendererText(text, x, y))
+		die("abort: %s\n", SDL_GetError());
+}
+
+/*
+ * Labels updated often mostly keep the same dimensions, their texture is
+ * reused in that case instead of creating a new one.
+ */
+static void
+ui_text_texture(struct texture *texture, unsigned int w, unsigned int h)
+{
+	/* An empty string has no width but a texture can't. */
+	w = w ? w : 1;
+	h = h ? h : 1;
+
+	if (texture->handle && texture->w == w && texture->h == h)
+		return;
+
+	texture_finish(texture);
+	texture_init(texture, w, h);
 }
 
 static inline void
@@ -234,6 +307,7 @@ void
 ui_resize(void)
 {
 	SDL_SetWindowSize(ui_win, PHY_W, PHY_H);
+	stris.dirty = 1;
 }
 
 void
@@ -259,32 +333,21 @@ ui_vprintf(struct texture *texture,
            const char *fmt,
            va_list ap)
 {
-	char text[128] = {};
-	SDL_Color c = {};
-	SDL_Surface *sf;
-	float w, h;
-
-	c.r = UI_COLOR_R(color);
-	c.g = UI_COLOR_G(color);
-	c.b = UI_COLOR_B(color);
-	c.a = UI_COLOR_A(color);
-
-	vsnprintf(text, sizeof (text), fmt, ap);
+	assert(texture);
+	assert(fmt);
 
-	if (!(sf = TTF_RenderText_Blended(fonts[f].font, text, strlen(text), c)))
-		die("abort: %s\n", SDL_GetError());
-	if (!(texture->handle = SDL_CreateTextureFromSurface(ui_rdr, sf)))
-		die("abort: %s\n", SDL_GetError());
-	if (!SDL_GetTextureSize(texture->handle, &w, &h))
-		die("abort: %s\n", SDL_GetError());
+	TTF_Text *text;
+	unsigned int w, h;
 
-	texture->w = w;
-	texture->h = h;
+	text = ui_vtext(f, &w, &h, fmt, ap);
+	ui_text_texture(texture, w, h);
 
-	SDL_DestroySurface(sf);
+	UI_BEGIN(texture);
+	ui_clear(0);
+	ui_text_draw(text, color, 0, 0);
+	UI_END();
 }
 
-
 void
 ui_printf_shadowed(struct texture *texture,
                    enum ui_font font,
@@ -311,35 +374,19 @@ ui_vprintf_shadowed(struct texture *texture,
 	assert(texture);
 	assert(fmt);
 
-	struct texture text;
+	TTF_Text *text;
 	unsigned int w, h;
-	va_list args;
 
-	/* Compute texture dimension. */
-	va_copy(args, ap);
-	ui_vclip(font, &w, &h, fmt, args);
-	va_end(args);
+	text = ui_vtext(font, &w, &h, fmt, ap);
 
 	/* Initialize texture with +1 in w/h for shadow. */
-	texture_init(texture, w + 1, h + 1);
+	ui_text_texture(texture, w + 1, h + 1);
 
-	/* Start drawing on this texture. */
+	/* Same glyphs drawn twice, shadow first. */
 	UI_BEGIN(texture);
 	ui_clear(0);
-
-	/* Go first with shadow. */
-	va_copy(args, ap);
-	ui_vprintf(&text, font, UI_PALETTE_SHADOW, fmt, args);
-	va_end(args);
-	texture_render(&text, 1, 1);
-	texture_finish(&text);
-
-	va_copy(args, ap);
-	ui_vprintf(&text, font, color, fmt, args);
-	va_end(args);
-	texture_render(&text, 0, 0);
-	texture_finish(&text);
-
+	ui_text_draw(text, UI_PALETTE_SHADOW, 1, 1);
+	ui_text_draw(text, color, 0, 0);
 	UI_END();
 }
 
@@ -351,7 +398,7 @@ ui_clip(enum ui_font font, unsigned int *w, unsigned int *h, const char *fmt, ..
 	va_list ap;
 
 	va_start(ap, fmt);
-	ui_vclip(font, w, h, fmt, ap);
+	ui_vtext(font, w, h, fmt, ap);
 	va_end(ap);
 }
 
@@ -388,11 +435,28 @@ ui_present(void)
 	SDL_RenderPresent(ui_rdr);
 }
 
+uint64_t
+ui_refresh(void)
+{
+	const SDL_DisplayMode *mode;
+
+	mode = SDL_GetCurrentDisplayMode(SDL_GetDisplayForWindow(ui_win));
+
+	if (!mode || mode->refresh_rate <= 0)
+		return SDL_NS_PER_SECOND / 60;
+
+	return SDL_NS_PER_SECOND / mode->refresh_rate;
+}
+
 struct texture *
 ui_target(struct texture *texture)
 {
 	struct texture *old = target;
 
+	/* Drawing on a texture is about to change what is on screen. */
+	if (texture)
+		stris.dirty = 1;
+
 	SDL_SetRenderTarget(ui_rdr, texture ? texture->handle : NULL);
 	target = texture;
 
@@ -134,7 +134,11 @@ ui_resize(void);
 /**
  * Render a string into a texture
  *
- * \param texture the texture to initialize (not NULL)
+ * If the texture was already rendered by this function it is updated in
+ * place and only recreated if the dimensions change, otherwise it must be
+ * zero'ed.
+ *
+ * \param texture the texture to initialize or update (not NULL)
  * \param font the font index to use
  * \param color the text color
  * \param fmt a printf(3) format string
@@ -216,6 +220,14 @@ ui_draw_rect(uint32_t color, int x, int y, int w, int h);
 void
 ui_present(void);
 
+/**
+ * Get the refresh period of the display showing the window.
+ *
+ * \return the period in nanoseconds, 60Hz if unknown
+ */
+uint64_t
+ui_refresh(void);
+
 /**
  * Change rendering context, returning current rendering.
  *
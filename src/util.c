@@ -33,11 +33,6 @@
 #       include <windows.h>
 #endif
 
-// For nrand()
-#if defined(__linux__)
-#      include <sys/random.h>
-#endif
-
 #include "util.h"
 
 void
@@ -88,22 +83,6 @@ username(void)
 
 #endif
 
-int
-nrand(int min, int max)
-{
-	unsigned int val;
-
-#if defined(__linux__)
-	getrandom(&val, sizeof (val), GRND_RANDOM);
-#elif defined(__OpenBSD__) || defined(__FreeBSD__) || defined(__NetBSD__) || defined(__APPLE__)
-	val = arc4random();
-#else
-	val = rand();
-#endif
-
-	return (val % (max - min + 1)) + min;
-}
-
 void *
 alloc(size_t n, size_t w)
 {
@@ -60,12 +60,6 @@ clamp(long long int v, long long int min, long long int max);
 const char *
 username(void);
 
-/**
- * Generate random number in range min..max (max excluded).
- */
-int
-nrand(int min, int max);
-
 /**
  * Allocate `n * w` bytes or exit with code 1.
  *